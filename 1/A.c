@@ -1,84 +1,522 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
+#include "common.h"
+#include "stats.h"
+#include "cpu.h"
+#include "job.h"
+#include "affinity.h"
+#include "pages.h"
+#include "memkern.h"
+#include "ioeng.h"
+#include "shared.h"
+#include "sync.h"
+#include "ipc.h"
+#include "pingpong.h"
+#include "scale.h"
+#include "fwq.h"
+#include "spawnbench.h"
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <signal.h>
 #include <sys/wait.h>
-#include <string.h>
+#include <sys/mman.h>
+
+extern char **environ;
+
+// Per-worker stats live in a MAP_SHARED array so children can report back
+worker_stats_t *stats = NULL;
+int num_procs = 1;
 
 // --- WORKER FUNCTIONS ---
-void cpu_worker() {
-    volatile double result = 0.0;
+void cpu_worker(int id) {
     // Fixed loop count to ensure consistency
-    for (int k = 0; k < 8*300; k++) { 
-        for (long i = 0; i < 100000; i++) {
-            result += (i * 0.001) + (k * 0.1);
+    cpu_range(0, CPU_OUTER_ITERS);
+    stats[id].ops = CPU_OUTER_ITERS;
+}
+
+void mem_worker(int id) {
+    mem_kernel_run(&stats[id], "progA", num_procs);
+}
+
+void io_worker(int id) {
+    if (share_mode != SHARE_NONE) {
+        share_run(&stats[id], 'A');
+        return;
+    }
+    // Unique file per worker (hybrid mode runs several per process)
+    char filename[32];
+    sprintf(filename, "io_%d_%d.dat", getpid(), id);
+    io_engine_run(&stats[id], filename, 'A');
+}
+
+void sync_worker(int id) {
+    sync_run(&stats[id]);
+}
+
+void ipc_worker(int id) {
+    ipc_run(&stats[id]);
+}
+
+void pingpong_worker(int id) {
+    ping_run(&stats[id]);
+}
+
+void idle_worker(int id) {
+    scale_run(&stats[id], 0);
+}
+
+void light_worker(int id) {
+    scale_run(&stats[id], 1);
+}
+
+void fwq_worker(int id) {
+    fwq_run(&stats[id]);
+}
+
+// --- STRONG SCALING ---
+// One fixed job is split into chunks. Processes claim the next chunk from a
+// counter in shared memory; the mem job's buffer is shared the same way.
+typedef struct {
+    long next_chunk;
+} chunk_counter_t;
+
+chunk_counter_t *counter = NULL;
+job_kind_t strong_kind = JOB_CPU;
+long num_chunks = DEFAULT_CHUNKS;
+volatile char *shared_mem = NULL;
+
+void strong_worker(int id) {
+    char filename[32];
+    sprintf(filename, "io_%d_%d.dat", getpid(), id);
+
+    job_ctx_t ctx;
+    if (job_ctx_open(&ctx, strong_kind, num_chunks, shared_mem, filename, 'A') < 0) return;
+
+    long c;
+    while ((c = __atomic_fetch_add(&counter->next_chunk, 1, __ATOMIC_RELAXED)) < num_chunks) {
+        run_chunk(&ctx, c);
+        stats[id].ops++;
+    }
+    job_ctx_close(&ctx);
+}
+
+// --- SPAWN COST ---
+// fork/vfork/clone children stamp their first instruction into a shared
+// page; a posix_spawn() child re-executes this program, which stamps it
+// into an inherited pipe before doing anything else.
+typedef enum { SPAWN_FORK, SPAWN_VFORK, SPAWN_POSIX, SPAWN_CLONE } spawn_prim_t;
+
+#define SPAWN_CHILD_ARG "--spawn-child"
+#define CLONE_STACK_SIZE (64 * 1024)
+
+const char *spawn_prim_names[] = {"fork", "vfork", "posix_spawn", "clone"};
+spawn_prim_t spawn_prim = SPAWN_FORK;
+volatile double *spawn_stamp = NULL;
+int spawn_pipe[2] = {-1, -1};
+char *clone_stack = NULL;
+
+int select_spawn_prim(const char *name) {
+    int p = find_name(spawn_prim_names, SPAWN_CLONE + 1, name);
+    if (p < 0) {
+        fprintf(stderr, "Unknown spawn primitive: %s\n", name);
+        return -1;
+    }
+    spawn_prim = (spawn_prim_t)p;
+    return 0;
+}
+
+// clone(CLONE_VM): a process that shares the parent's address space, so no
+// page tables are copied (what posix_spawn uses internally, without the exec)
+int clone_child(void *arg) {
+    *spawn_stamp = now_sec();
+    return 0;
+}
+
+int spawn_process(double *start, double *reap) {
+    char fd_arg[16];
+    char *args[] = {"progA", SPAWN_CHILD_ARG, fd_arg, NULL};
+    snprintf(fd_arg, sizeof(fd_arg), "%d", spawn_pipe[1]);
+
+    pid_t pid = -1;
+    double t0 = now_sec();
+    if (spawn_prim == SPAWN_FORK) {
+        pid = fork();
+        if (pid == 0) {
+            *spawn_stamp = now_sec();
+            _exit(0);
+        }
+    } else if (spawn_prim == SPAWN_VFORK) {
+        pid = vfork();
+        if (pid == 0) {
+            *spawn_stamp = now_sec();
+            _exit(0);
         }
+    } else if (spawn_prim == SPAWN_POSIX) {
+        if (posix_spawn(&pid, "/proc/self/exe", NULL, NULL, args, environ) != 0) pid = -1;
+    } else {
+        pid = clone(clone_child, clone_stack + CLONE_STACK_SIZE, CLONE_VM | SIGCHLD, NULL);
     }
+    if (pid < 0) return -1;
+    if (waitpid(pid, NULL, 0) < 0) return -1;
+    *reap = now_sec() - t0;
+
+    double child_t = *spawn_stamp;
+    if (spawn_prim == SPAWN_POSIX && read(spawn_pipe[0], &child_t, sizeof(child_t)) != sizeof(child_t)) {
+        return -1;
+    }
+    *start = child_t - t0;
+    return 0;
 }
 
-void mem_worker() {
-    long size = 100 * 1024 * 1024; // 100MB
-    volatile char *arr = (char*)malloc(size);
-    if (!arr) return;
-    for (int k = 0; k < 8*400; k++) {
-        for (long i = 0; i < size; i += 4096) arr[i] = (char)(k % 128);
+int spawn_main(int samples) {
+    spawn_stamp = mmap(NULL, MEM_PAGE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    clone_stack = malloc(CLONE_STACK_SIZE);
+    if (spawn_stamp == MAP_FAILED || !clone_stack || pipe(spawn_pipe) < 0) {
+        perror("spawn setup failed");
+        return 1;
     }
-    free((void*)arr);
+    int rc = spawn_bench("progA", spawn_prim_names[spawn_prim], samples, spawn_process);
+    close(spawn_pipe[0]);
+    close(spawn_pipe[1]);
+    free(clone_stack);
+    munmap((void*)spawn_stamp, MEM_PAGE);
+    return rc < 0 ? 1 : 0;
 }
 
-void io_worker() {
-    char filename[32];
-    sprintf(filename, "io_%d.dat", getpid()); // Unique file per process
-    FILE *fp = fopen(filename, "w");
-    if (!fp) return;
-
-    char buffer[1024];
-    memset(buffer, 'A', 1024);
-
-    // Using your updated loop count logic
-    for (int i = 0; i < 80000; i++) {
-        fwrite(buffer, 1, 1024, fp);
-        if (i % 1000 == 0) {
-            fflush(fp);
-            fsync(fileno(fp));
+void run_worker(void (*worker)(int), int id) {
+    affinity_apply(id);
+    stats_begin(&stats[id], id, RUSAGE_SELF);
+    worker(id);
+    stats_end(&stats[id], RUSAGE_SELF);
+}
+
+// --- HYBRID P x T ---
+// With -T, each of the N/T processes runs T threads; process p hosts
+// workers p*T .. p*T+T-1. All shared job state already lives in MAP_SHARED
+// memory with process-shared locks, so every worker type runs unchanged.
+int threads_per_proc = 1;
+void (*hybrid_worker)(int) = NULL;
+
+void *hybrid_thread(void *arg) {
+    int id = (int)(long)arg;
+    affinity_apply(id);
+    stats_begin(&stats[id], id, RUSAGE_THREAD);
+    hybrid_worker(id);
+    stats_end(&stats[id], RUSAGE_THREAD);
+    return NULL;
+}
+
+// Children forked so far, so a failed run can be torn down
+pid_t *child_pids = NULL;
+int num_children = 0;
+
+// Worker creation failed for a job other than idle/light. Those workers pair
+// up or meet at barriers (ipc, pingpong, sync, shared files), so a partial
+// run would wait forever for the missing ones: kill and reap the children
+// and fail the run.
+void abort_run(void) {
+    for (int i = 0; i < num_children; i++) kill(child_pids[i], SIGKILL);
+    for (int i = 0; i < num_children; i++) waitpid(child_pids[i], NULL, 0);
+    _exit(1);
+}
+
+// A child could not start its -T threads: the parent tears the run down
+void on_child_abort(int sig) {
+    (void)sig;
+    abort_run();
+}
+
+void run_process(void (*worker)(int), int p) {
+    if (threads_per_proc == 1) {
+        run_worker(worker, p);
+        return;
+    }
+    pthread_t threads[threads_per_proc];
+    int started = 0;
+    hybrid_worker = worker;
+    for (int t = 0; t < threads_per_proc; t++) {
+        int rc = pthread_create(&threads[t], NULL, hybrid_thread, (void*)(long)(p * threads_per_proc + t));
+        if (rc != 0) {
+            fprintf(stderr, "pthread_create failed: %s\n", strerror(rc));
+            if (strong_kind == JOB_SCALE) break;
+            if (p == 0) abort_run();
+            kill(getppid(), SIGUSR1);
+            _exit(1);
         }
+        started++;
     }
-    fsync(fileno(fp));
-    fclose(fp);
-    remove(filename);
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
 }
 
 // --- MAIN ---
 int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        printf("Usage: %s [cpu|mem|io] [num_processes]\n", argv[0]);
+    // posix_spawn() child of spawn mode: report the first instruction and exit
+    if (argc == 3 && strcmp(argv[1], SPAWN_CHILD_ARG) == 0) {
+        double t = now_sec();
+        ssize_t n = write(atoi(argv[2]), &t, sizeof(t));
+        _exit(n == sizeof(t) ? 0 : 1);
+    }
+
+    const char *stats_path = STATS_DEFAULT_FILE;
+    int strong = 0;
+    int hybrid = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:Sc:k:m:g:b:e:s:B:q:W:a:y:p:R:t:r:w:T:")) != -1) {
+        if (opt == 'o') stats_path = optarg;
+        else if (opt == 'k') {
+            if (select_cpu_kernel(optarg) < 0) return 1;
+        } else if (opt == 'm') {
+            if (select_mem_kernel(optarg) < 0) return 1;
+        } else if (opt == 'g') {
+            if (select_page_mode(optarg) < 0) return 1;
+        } else if (opt == 'b') cow_size = (size_t)atol(optarg) << 20;
+        else if (opt == 'e') {
+            if (select_io_engine(optarg) < 0) return 1;
+        } else if (opt == 's') {
+            if (select_io_sync(optarg) < 0) return 1;
+        } else if (opt == 'B') io_block = atol(optarg);
+        else if (opt == 'q') io_depth = atoi(optarg);
+        else if (opt == 'W') {
+            if (select_share_mode(optarg) < 0) return 1;
+        } else if (opt == 'a') {
+            if (select_affinity(optarg) < 0) return 1;
+        } else if (opt == 'y') {
+            if (select_sync_variant(optarg) < 0) return 1;
+        } else if (opt == 'p') {
+            if (select_spawn_prim(optarg) < 0) return 1;
+        } else if (opt == 'R') spawn_rss_mb = atol(optarg);
+        else if (opt == 't') {
+            if (select_ipc_transport(optarg) < 0) return 1;
+        } else if (opt == 'r') ipc_record = atol(optarg);
+        else if (opt == 'w') {
+            if (select_wake_mech(optarg) < 0) return 1;
+        }
+        else if (opt == 'T') {
+            threads_per_proc = atoi(optarg);
+            hybrid = 1;
+        }
+        else if (opt == 'S') strong = 1;
+        else if (opt == 'c') num_chunks = atol(optarg);
+        else return 1;
+    }
+
+    if (argc - optind < 2 || num_chunks < 1) {
+        printf("Usage: %s [-o stats.csv] [-S [-c chunks]] [-k cpu_kernel] [-m mem_kernel] [-g pages] [-b cow_mb]\n"
+               "       [-e io_engine] [-s sync] [-B block] [-q depth] [-W shared_mode]\n"
+               "       [-a affinity] [-y sync_variant] [-p spawn_primitive] [-R rss_mb]\n"
+               "       [-t ipc_transport] [-r record_bytes] [-w wake[+spin]] [-T threads_per_process]\n"
+               "       [cpu|mem|io|sync|ipc|pingpong|idle|light|fwq|spawn] [num_processes]\n", argv[0]);
         return 1;
     }
+    const char *worker_name = argv[optind];
 
-    int num_procs = atoi(argv[2]);
+    num_procs = atoi(argv[optind + 1]);
     if (num_procs < 1) num_procs = 1;
 
-    void (*worker)() = NULL;
-    if (strcmp(argv[1], "cpu") == 0) worker = cpu_worker;
-    else if (strcmp(argv[1], "mem") == 0) worker = mem_worker;
-    else if (strcmp(argv[1], "io") == 0) worker = io_worker;
-    else return 1;
+    // spawn: N is the number of timed spawns
+    if (strcmp(worker_name, "spawn") == 0) return spawn_main(num_procs);
+
+    void (*worker)(int) = NULL;
+    if (strcmp(worker_name, "cpu") == 0) {
+        worker = cpu_worker;
+        strong_kind = JOB_CPU;
+    } else if (strcmp(worker_name, "mem") == 0) {
+        worker = mem_worker;
+        strong_kind = JOB_MEM;
+    } else if (strcmp(worker_name, "io") == 0) {
+        worker = io_worker;
+        strong_kind = JOB_IO;
+    } else if (strcmp(worker_name, "sync") == 0) {
+        worker = sync_worker;
+        strong_kind = JOB_SYNC;
+    } else if (strcmp(worker_name, "ipc") == 0) {
+        worker = ipc_worker;
+        strong_kind = JOB_IPC;
+        num_procs *= 2; // N pairs
+    } else if (strcmp(worker_name, "pingpong") == 0) {
+        worker = pingpong_worker;
+        strong_kind = JOB_PING;
+        num_procs *= 2; // N pairs
+    } else if (strcmp(worker_name, "idle") == 0) {
+        worker = idle_worker;
+        strong_kind = JOB_SCALE;
+    } else if (strcmp(worker_name, "light") == 0) {
+        worker = light_worker;
+        strong_kind = JOB_SCALE;
+    } else if (strcmp(worker_name, "fwq") == 0) {
+        worker = fwq_worker;
+        strong_kind = JOB_FWQ;
+    } else return 1;
+
+    if (strong && mem_kernel != MEM_TOUCH) {
+        fprintf(stderr, "Memory kernels other than touch run in the default mode only\n");
+        return 1;
+    }
+    if (strong && !io_is_default()) {
+        fprintf(stderr, "I/O engines other than stdio+fsync run in the default mode only\n");
+        return 1;
+    }
+    if (threads_per_proc < 1 || num_procs % threads_per_proc != 0) {
+        fprintf(stderr, "-T must divide the number of workers (%d)\n", num_procs);
+        return 1;
+    }
+    if (io_check_config() < 0) return 1;
+    if (affinity_setup() < 0) return 1;
+    if (strong && (strong_kind == JOB_SYNC || strong_kind == JOB_IPC ||
+                   strong_kind == JOB_PING || strong_kind == JOB_SCALE || strong_kind == JOB_FWQ)) {
+        fprintf(stderr, "The %s worker runs in the default mode only\n", worker_name);
+        return 1;
+    }
+    if (strong_kind == JOB_SYNC && sync_setup(num_procs) < 0) return 1;
+    if (strong_kind == JOB_IPC && ipc_setup(num_procs / 2) < 0) return 1;
+    if (strong_kind == JOB_PING && ping_setup(num_procs / 2) < 0) return 1;
+    if (strong_kind == JOB_FWQ && fwq_setup(num_procs) < 0) return 1;
+    if (share_mode != SHARE_NONE && (strong || !io_is_default())) {
+        fprintf(stderr, "Shared-file modes use their own write path (no -S, -e, -s or -B)\n");
+        return 1;
+    }
+
+    if (strong) {
+        // Shared chunk counter (and shared buffer for mem), set up before fork
+        worker = strong_worker;
+        counter = mmap(NULL, sizeof(chunk_counter_t), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (counter == MAP_FAILED) {
+            perror("mmap failed");
+            return 1;
+        }
+        counter->next_chunk = 0;
+        if (strong_kind == JOB_MEM) {
+            shared_mem = mmap(NULL, MEM_SIZE, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (shared_mem == MAP_FAILED) {
+                perror("mmap failed");
+                return 1;
+            }
+        }
+    }
+
+    size_t stats_size = sizeof(worker_stats_t) * num_procs;
+    stats = mmap(NULL, stats_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stats == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+
+    // Shared-file modes: one file (and group-commit writer) for all workers
+    if (strong_kind == JOB_IO && share_mode != SHARE_NONE && share_open() < 0) return 1;
 
-    // Create N-1 Children
-    for(int i = 0; i < num_procs - 1; i++) {
+    // Copy-on-write study: the parent owns a touched buffer before forking
+    if (strong_kind == JOB_MEM && mem_kernel_is_cow() && cow_prepare() < 0) return 1;
+
+    worker_stats_t run;
+    stats_begin(&run, -1, RUSAGE_SELF);
+
+    if (strong_kind == JOB_SCALE && scale_setup(stats, num_procs) < 0) return 1;
+
+    fflush(stdout); // Children print (MEMSWEEP) and must not repeat buffered output
+    // Create P-1 Children (P = N without -T)
+    int procs = num_procs / threads_per_proc;
+    child_pids = malloc(sizeof(pid_t) * procs);
+    if (!child_pids) {
+        perror("malloc failed");
+        return 1;
+    }
+    // A child's SIGUSR1 (see run_process) waits until every pid is recorded
+    sigset_t abort_set;
+    sigemptyset(&abort_set);
+    sigaddset(&abort_set, SIGUSR1);
+    signal(SIGUSR1, on_child_abort);
+    sigprocmask(SIG_BLOCK, &abort_set, NULL);
+    double spawn_t0 = now_sec();
+    for(int i = 0; i < procs - 1; i++) {
         pid_t pid = fork();
         if (pid == 0) {
-            worker();
+            run_process(worker, i + 1);
             exit(0);
         }
+        if (pid < 0) {
+            perror("fork failed");
+            if (strong_kind != JOB_SCALE) abort_run();
+            // Out of processes (ulimit -u, pid_max, memory): idle/light run
+            // with what exists
+            procs = i + 1;
+            num_procs = procs * threads_per_proc;
+            scale_limit(num_procs);
+            break;
+        }
+        child_pids[num_children++] = pid;
     }
+    sigprocmask(SIG_UNBLOCK, &abort_set, NULL);
+    cow_setup.spawn_s = now_sec() - spawn_t0;
 
-    // Parent also works (Total = N processes)
-    worker();
+    // Parent also works (Total = N workers)
+    run_process(worker, 0);
 
     // Wait for all children
-    for(int i = 0; i < num_procs - 1; i++) {
+    for(int i = 0; i < procs - 1; i++) {
         wait(NULL);
     }
+    double teardown_end = now_sec();
 
-    return 0;
+    // Run row: parent + reaped children; memory is the sum of per-process
+    // peaks (threads report their process's peak, so count one per process)
+    stats_end(&run, RUSAGE_SELF);
+    stats_add_children(&run);
+    stats_sum_io(&run, stats, num_procs);
+    run.maxrss_kb = 0;
+    for (int i = 0; i < num_procs; i += threads_per_proc) run.maxrss_kb += stats[i].maxrss_kb;
+
+    FILE *out = stats_open(stats_path);
+    if (out) {
+        char run_id[32];
+        make_run_id(run_id, sizeof(run_id));
+        for (int i = 0; i < num_procs; i++) {
+            stats_write(out, run_id, "progA", worker_name, num_procs, "worker", &stats[i]);
+        }
+        stats_write(out, run_id, "progA", worker_name, num_procs, "run", &run);
+        fclose(out);
+    }
+
+    int status = 0;
+    if (strong_kind == JOB_SYNC && report_sync("progA", num_procs, stats) < 0) status = 1;
+    if (strong_kind == JOB_IPC && report_ipc("progA", num_procs, stats) < 0) status = 1;
+    if (strong_kind == JOB_PING) report_pingpong("progA", num_procs, stats);
+    if (strong_kind == JOB_FWQ) report_fwq("progA", num_procs, stats);
+    if (strong_kind == JOB_SCALE) report_scale("progA", worker_name, num_procs, teardown_end);
+    if (strong_kind == JOB_IO && !strong) {
+        if (share_mode != SHARE_NONE) report_shared("progA", num_procs, stats);
+        else report_io("progA", num_procs, stats);
+    }
+    if (strong_kind == JOB_MEM && !strong) {
+        if (mem_kernel == MEM_TOUCH || mem_kernel_is_cow()) report_pages("progA", num_procs, stats);
+        else if (mem_kernel != MEM_SWEEP && report_membw("progA", num_procs, stats) < 0) status = 1;
+    }
+    if (strong_kind == JOB_CPU) {
+        report_gflops("progA", num_procs, stats, &run,
+                      strong ? (double)CPU_OUTER_ITERS / num_chunks : 1.0);
+    }
+
+    if (hybrid) {
+        // HYBRID,<program>,<worker>,<N>,<P>,<T>,<wall_s>,<ops/s>,<maxrss_kb>,<nvcsw>,<nivcsw>
+        printf("HYBRID,progA,%s,%d,%d,%d,%.6f,%.1f,%ld,%ld,%ld\n", worker_name, num_procs, procs,
+               threads_per_proc, run.wall_s, run.wall_s > 0 ? run.ops / run.wall_s : 0.0,
+               run.maxrss_kb, run.nvcsw, run.nivcsw);
+    }
+
+    if (strong) {
+        // STRONG,<program>,<worker>,<N>,<chunks>,<wall_s>
+        printf("STRONG,progA,%s,%d,%ld,%.6f\n", worker_name, num_procs, num_chunks, run.wall_s);
+        if (shared_mem) munmap((void*)shared_mem, MEM_SIZE);
+        munmap(counter, sizeof(chunk_counter_t));
+    }
+
+    cow_release();
+    share_close();
+    sync_release();
+    ipc_release();
+    ping_release();
+    scale_release();
+    fwq_release();
+    munmap(stats, stats_size);
+    return status;
 }
\ No newline at end of file
@@ -1,83 +1,425 @@
-#include <stdio.h>
-#include <stdlib.h>
+#include "common.h"
+#include "stats.h"
+#include "cpu.h"
+#include "job.h"
+#include "affinity.h"
+#include "pages.h"
+#include "memkern.h"
+#include "ioeng.h"
+#include "shared.h"
+#include "sync.h"
+#include "ipc.h"
+#include "pingpong.h"
+#include "scale.h"
+#include "fwq.h"
+#include "spawnbench.h"
 #include <pthread.h>
-#include <string.h>
-#include <unistd.h>
+
+worker_stats_t *stats = NULL;
+int num_threads = 1;
 
 // --- WORKER FUNCTIONS ---
-void cpu_worker() {
-    volatile double result = 0.0;
-    for (int k = 0; k < 8*300; k++) { 
-        for (long i = 0; i < 100000; i++) result += (i * 0.001) + (k * 0.1);
-    }
+void cpu_worker(int id) {
+    cpu_range(0, CPU_OUTER_ITERS);
+    stats[id].ops = CPU_OUTER_ITERS;
 }
 
-void mem_worker() {
-    long size = 100 * 1024 * 1024;
-    volatile char *arr = (char*)malloc(size);
-    if (!arr) return;
-    for (int k = 0; k < 8*400; k++) {
-        for (long i = 0; i < size; i += 4096) arr[i] = (char)(k % 128);
-    }
-    free((void*)arr);
+void mem_worker(int id) {
+    mem_kernel_run(&stats[id], "progB", num_threads);
 }
 
-void io_worker() {
+void io_worker(int id) {
+    if (share_mode != SHARE_NONE) {
+        share_run(&stats[id], 'B');
+        return;
+    }
     // Unique filename based on thread ID to avoid collision
     char filename[32];
     sprintf(filename, "io_th_%lu.dat", pthread_self());
-    FILE *fp = fopen(filename, "w");
-    if (!fp) return;
+    io_engine_run(&stats[id], filename, 'B');
+}
+
+void sync_worker(int id) {
+    sync_run(&stats[id]);
+}
+
+void ipc_worker(int id) {
+    ipc_run(&stats[id]);
+}
+
+void pingpong_worker(int id) {
+    ping_run(&stats[id]);
+}
 
-    char buffer[1024];
-    memset(buffer, 'B', 1024);
+void idle_worker(int id) {
+    scale_run(&stats[id], 0);
+}
+
+void light_worker(int id) {
+    scale_run(&stats[id], 1);
+}
+
+void fwq_worker(int id) {
+    fwq_run(&stats[id]);
+}
+
+// --- STRONG SCALING ---
+// One fixed job is split into chunks. Each thread starts with a contiguous
+// block of chunks in its own deque, pops from the bottom, and when it runs
+// dry steals from the top of another thread's deque.
+typedef struct {
+    pthread_mutex_t lock;
+    long *items;
+    int head;   // Thieves take from here
+    int tail;   // Owner pushes/pops here
+} deque_t;
 
-    for (int i = 0; i < 80000; i++) {
-        fwrite(buffer, 1, 1024, fp);
-        if (i % 1000 == 0) {
-            fflush(fp);
-            fsync(fileno(fp));
+deque_t *deques = NULL;
+int num_deques = 0;
+long num_chunks = DEFAULT_CHUNKS;
+job_kind_t strong_kind = JOB_CPU;
+volatile char *shared_mem = NULL;
+long *steals = NULL;
+
+int deque_pop(deque_t *d, long *out) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *out = d->items[--d->tail];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+int deque_steal(deque_t *d, long *out) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *out = d->items[d->head++];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+// Own deque first, then one pass over the others. Chunks are never added
+// after startup, so finding every deque empty means the job is done.
+int next_chunk(int id, long *out) {
+    if (deque_pop(&deques[id], out)) return 1;
+    for (int k = 1; k < num_deques; k++) {
+        if (deque_steal(&deques[(id + k) % num_deques], out)) {
+            steals[id]++;
+            return 1;
         }
     }
-    fsync(fileno(fp));
-    fclose(fp);
-    remove(filename);
+    return 0;
+}
+
+void strong_worker(int id) {
+    char filename[32];
+    sprintf(filename, "io_th_%lu.dat", pthread_self());
+
+    job_ctx_t ctx;
+    if (job_ctx_open(&ctx, strong_kind, num_chunks, shared_mem, filename, 'B') < 0) return;
+
+    long c;
+    while (next_chunk(id, &c)) {
+        run_chunk(&ctx, c);
+        stats[id].ops++;
+    }
+    job_ctx_close(&ctx);
+}
+
+int setup_deques(int n) {
+    deques = (deque_t*)calloc(n, sizeof(deque_t));
+    steals = (long*)calloc(n, sizeof(long));
+    if (!deques || !steals) return -1;
+    num_deques = n;
+    for (int i = 0; i < n; i++) {
+        long begin = num_chunks * i / n, end = num_chunks * (i + 1) / n;
+        pthread_mutex_init(&deques[i].lock, NULL);
+        deques[i].items = (long*)malloc(sizeof(long) * (end - begin + 1));
+        if (!deques[i].items) return -1;
+        // Stored in reverse so the owner pops its block in ascending order
+        for (long c = end - 1; c >= begin; c--) deques[i].items[deques[i].tail++] = c;
+    }
+    return 0;
+}
+
+void free_deques(void) {
+    for (int i = 0; i < num_deques; i++) {
+        pthread_mutex_destroy(&deques[i].lock);
+        free(deques[i].items);
+    }
+    free(deques);
+    free(steals);
+}
+
+// --- SPAWN COST ---
+// The thread stamps its first instruction; reaping is pthread_join()
+double spawn_stamp = 0.0;
+
+void *spawn_thread(void *arg) {
+    spawn_stamp = now_sec();
+    return NULL;
+}
+
+// Threads have a single primitive
+int select_spawn_prim(const char *name) {
+    if (strcmp(name, "pthread") != 0) {
+        fprintf(stderr, "Unknown spawn primitive: %s (progB only has pthread)\n", name);
+        return -1;
+    }
+    return 0;
 }
 
-void (*global_worker)() = NULL;
+int spawn_thread_once(double *start, double *reap) {
+    pthread_t t;
+    double t0 = now_sec();
+    if (pthread_create(&t, NULL, spawn_thread, NULL) != 0) return -1;
+    pthread_join(t, NULL);
+    *reap = now_sec() - t0;
+    *start = spawn_stamp - t0; // join orders the thread's store before this read
+    return 0;
+}
+
+void (*global_worker)(int) = NULL;
 
 void* thread_wrapper(void* arg) {
-    global_worker();
+    int id = (int)(long)arg;
+    affinity_apply(id);
+    stats_begin(&stats[id], id, RUSAGE_THREAD);
+    global_worker(id);
+    stats_end(&stats[id], RUSAGE_THREAD);
     return NULL;
 }
 
 // --- MAIN ---
 int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        printf("Usage: %s [cpu|mem|io] [num_threads]\n", argv[0]);
+    const char *stats_path = STATS_DEFAULT_FILE;
+    int strong = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:Sc:k:m:g:b:e:s:B:q:W:a:y:p:R:t:r:w:z:")) != -1) {
+        if (opt == 'o') stats_path = optarg;
+        else if (opt == 'k') {
+            if (select_cpu_kernel(optarg) < 0) return 1;
+        } else if (opt == 'm') {
+            if (select_mem_kernel(optarg) < 0) return 1;
+        } else if (opt == 'g') {
+            if (select_page_mode(optarg) < 0) return 1;
+        } else if (opt == 'b') cow_size = (size_t)atol(optarg) << 20;
+        else if (opt == 'e') {
+            if (select_io_engine(optarg) < 0) return 1;
+        } else if (opt == 's') {
+            if (select_io_sync(optarg) < 0) return 1;
+        } else if (opt == 'B') io_block = atol(optarg);
+        else if (opt == 'q') io_depth = atoi(optarg);
+        else if (opt == 'W') {
+            if (select_share_mode(optarg) < 0) return 1;
+        } else if (opt == 'a') {
+            if (select_affinity(optarg) < 0) return 1;
+        } else if (opt == 'y') {
+            if (select_sync_variant(optarg) < 0) return 1;
+        } else if (opt == 'p') {
+            if (select_spawn_prim(optarg) < 0) return 1;
+        } else if (opt == 'R') spawn_rss_mb = atol(optarg);
+        else if (opt == 't') {
+            if (select_ipc_transport(optarg) < 0) return 1;
+        } else if (opt == 'r') ipc_record = atol(optarg);
+        else if (opt == 'w') {
+            if (select_wake_mech(optarg) < 0) return 1;
+        }
+        else if (opt == 'z') thread_stack_kb = atol(optarg);
+        else if (opt == 'S') strong = 1;
+        else if (opt == 'c') num_chunks = atol(optarg);
+        else return 1;
+    }
+
+    if (argc - optind < 2 || num_chunks < 1) {
+        printf("Usage: %s [-o stats.csv] [-S [-c chunks]] [-k cpu_kernel] [-m mem_kernel] [-g pages] [-b cow_mb]\n"
+               "       [-e io_engine] [-s sync] [-B block] [-q depth] [-W shared_mode]\n"
+               "       [-a affinity] [-y sync_variant] [-p spawn_primitive] [-R rss_mb]\n"
+               "       [-t ipc_transport] [-r record_bytes] [-w wake[+spin]] [-z stack_kb]\n"
+               "       [cpu|mem|io|sync|ipc|pingpong|idle|light|fwq|spawn] [num_threads]\n", argv[0]);
         return 1;
     }
+    const char *worker_name = argv[optind];
 
-    int num_threads = atoi(argv[2]);
+    num_threads = atoi(argv[optind + 1]);
     if (num_threads < 1) num_threads = 1;
 
-    if (strcmp(argv[1], "cpu") == 0) global_worker = cpu_worker;
-    else if (strcmp(argv[1], "mem") == 0) global_worker = mem_worker;
-    else if (strcmp(argv[1], "io") == 0) global_worker = io_worker;
-    else return 1;
+    // spawn: N is the number of timed spawns
+    if (strcmp(worker_name, "spawn") == 0) {
+        return spawn_bench("progB", "pthread", num_threads, spawn_thread_once) < 0 ? 1 : 0;
+    }
+
+    if (strcmp(worker_name, "cpu") == 0) {
+        global_worker = cpu_worker;
+        strong_kind = JOB_CPU;
+    } else if (strcmp(worker_name, "mem") == 0) {
+        global_worker = mem_worker;
+        strong_kind = JOB_MEM;
+    } else if (strcmp(worker_name, "io") == 0) {
+        global_worker = io_worker;
+        strong_kind = JOB_IO;
+    } else if (strcmp(worker_name, "sync") == 0) {
+        global_worker = sync_worker;
+        strong_kind = JOB_SYNC;
+    } else if (strcmp(worker_name, "ipc") == 0) {
+        global_worker = ipc_worker;
+        strong_kind = JOB_IPC;
+        num_threads *= 2; // N pairs
+    } else if (strcmp(worker_name, "pingpong") == 0) {
+        global_worker = pingpong_worker;
+        strong_kind = JOB_PING;
+        num_threads *= 2; // N pairs
+    } else if (strcmp(worker_name, "idle") == 0) {
+        global_worker = idle_worker;
+        strong_kind = JOB_SCALE;
+    } else if (strcmp(worker_name, "light") == 0) {
+        global_worker = light_worker;
+        strong_kind = JOB_SCALE;
+    } else if (strcmp(worker_name, "fwq") == 0) {
+        global_worker = fwq_worker;
+        strong_kind = JOB_FWQ;
+    } else return 1;
+
+    if (strong && mem_kernel != MEM_TOUCH) {
+        fprintf(stderr, "Memory kernels other than touch run in the default mode only\n");
+        return 1;
+    }
+    if (strong && !io_is_default()) {
+        fprintf(stderr, "I/O engines other than stdio+fsync run in the default mode only\n");
+        return 1;
+    }
+    if (io_check_config() < 0) return 1;
+    if (affinity_setup() < 0) return 1;
+    if (strong && (strong_kind == JOB_SYNC || strong_kind == JOB_IPC ||
+                   strong_kind == JOB_PING || strong_kind == JOB_SCALE || strong_kind == JOB_FWQ)) {
+        fprintf(stderr, "The %s worker runs in the default mode only\n", worker_name);
+        return 1;
+    }
+    if (strong_kind == JOB_SYNC && sync_setup(num_threads) < 0) return 1;
+    if (strong_kind == JOB_IPC && ipc_setup(num_threads / 2) < 0) return 1;
+    if (strong_kind == JOB_PING && ping_setup(num_threads / 2) < 0) return 1;
+    if (strong_kind == JOB_FWQ && fwq_setup(num_threads) < 0) return 1;
+    if (share_mode != SHARE_NONE && (strong || !io_is_default())) {
+        fprintf(stderr, "Shared-file modes use their own write path (no -S, -e, -s or -B)\n");
+        return 1;
+    }
+
+    if (strong) {
+        global_worker = strong_worker;
+        if (setup_deques(num_threads) < 0) {
+            perror("Deque allocation failed");
+            return 1;
+        }
+        if (strong_kind == JOB_MEM) {
+            shared_mem = (volatile char*)malloc(MEM_SIZE);
+            if (!shared_mem) return 1;
+        }
+    }
 
     pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t) * num_threads);
+    stats = (worker_stats_t*)calloc(num_threads, sizeof(worker_stats_t));
+
+    // Shared-file modes: one file (and group-commit writer) for all workers
+    if (strong_kind == JOB_IO && share_mode != SHARE_NONE && share_open() < 0) return 1;
+
+    // Copy-on-write study: threads share the main thread's touched buffer
+    if (strong_kind == JOB_MEM && mem_kernel_is_cow() && cow_prepare() < 0) return 1;
+
+    worker_stats_t run;
+    stats_begin(&run, -1, RUSAGE_SELF);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (thread_stack_kb > 0 && pthread_attr_setstacksize(&attr, (size_t)thread_stack_kb << 10) != 0) {
+        fprintf(stderr, "Invalid thread stack size: %ldKB\n", thread_stack_kb);
+        return 1;
+    }
+    if (strong_kind == JOB_SCALE && scale_setup(stats, num_threads) < 0) return 1;
 
     // Create N threads
+    double spawn_t0 = now_sec();
     for (int i = 0; i < num_threads; i++) {
-        pthread_create(&threads[i], NULL, thread_wrapper, NULL);
+        int rc = pthread_create(&threads[i], &attr, thread_wrapper, (void*)(long)i);
+        if (rc != 0 && i > 0 && strong_kind == JOB_SCALE) {
+            // Out of threads (threads-max, memory): idle/light run with what exists
+            fprintf(stderr, "pthread_create failed: %s\n", strerror(rc));
+            num_threads = i;
+            scale_limit(num_threads);
+            break;
+        } else if (rc != 0) {
+            // Other workers pair up or meet at barriers (ipc, pingpong, sync,
+            // shared files), so the started ones would wait forever for the
+            // missing ones: fail the run (returning ends them too)
+            fprintf(stderr, "pthread_create failed: %s\n", strerror(rc));
+            return 1;
+        }
     }
+    pthread_attr_destroy(&attr);
+    cow_setup.spawn_s = now_sec() - spawn_t0;
 
     // Join N threads
     for (int i = 0; i < num_threads; i++) {
         pthread_join(threads[i], NULL);
     }
+    double teardown_end = now_sec();
+
+    // Run row: RUSAGE_SELF already covers every thread of the process
+    stats_end(&run, RUSAGE_SELF);
+    stats_sum_io(&run, stats, num_threads);
 
+    FILE *out = stats_open(stats_path);
+    if (out) {
+        char run_id[32];
+        make_run_id(run_id, sizeof(run_id));
+        for (int i = 0; i < num_threads; i++) {
+            stats_write(out, run_id, "progB", worker_name, num_threads, "worker", &stats[i]);
+        }
+        stats_write(out, run_id, "progB", worker_name, num_threads, "run", &run);
+        fclose(out);
+    }
+
+    int status = 0;
+    if (strong_kind == JOB_SYNC && report_sync("progB", num_threads, stats) < 0) status = 1;
+    if (strong_kind == JOB_IPC && report_ipc("progB", num_threads, stats) < 0) status = 1;
+    if (strong_kind == JOB_PING) report_pingpong("progB", num_threads, stats);
+    if (strong_kind == JOB_FWQ) report_fwq("progB", num_threads, stats);
+    if (strong_kind == JOB_SCALE) report_scale("progB", worker_name, num_threads, teardown_end);
+    if (strong_kind == JOB_IO && !strong) {
+        if (share_mode != SHARE_NONE) report_shared("progB", num_threads, stats);
+        else report_io("progB", num_threads, stats);
+    }
+    if (strong_kind == JOB_MEM && !strong) {
+        if (mem_kernel == MEM_TOUCH || mem_kernel_is_cow()) report_pages("progB", num_threads, stats);
+        else if (mem_kernel != MEM_SWEEP && report_membw("progB", num_threads, stats) < 0) status = 1;
+    }
+    if (strong_kind == JOB_CPU) {
+        report_gflops("progB", num_threads, stats, &run,
+                      strong ? (double)CPU_OUTER_ITERS / num_chunks : 1.0);
+    }
+
+    if (strong) {
+        long total_steals = 0;
+        for (int i = 0; i < num_threads; i++) total_steals += steals[i];
+        // STRONG,<program>,<worker>,<N>,<chunks>,<wall_s>,<steals>
+        printf("STRONG,progB,%s,%d,%ld,%.6f,%ld\n", worker_name, num_threads, num_chunks,
+               run.wall_s, total_steals);
+        free((void*)shared_mem);
+        free_deques();
+    }
+
+    cow_release();
+    share_close();
+    sync_release();
+    ipc_release();
+    ping_release();
+    scale_release();
+    fwq_release();
+    free(stats);
     free(threads);
-    return 0;
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "affinity.h"
+#include <sched.h>
+
+typedef enum { AFF_NONE, AFF_SINGLE, AFF_COMPACT, AFF_SPREAD, AFF_SMT, AFF_NUMA, AFF_PAIR } aff_policy_t;
+
+static const char *aff_policy_names[] = {"none", "single", "compact", "spread", "smt", "numa", "pair"};
+static aff_policy_t aff_policy = AFF_NONE;
+static int aff_arg = -1;           // CPU for single, node for numa
+static int *aff_plan = NULL;       // CPU per plan slot
+static int aff_plan_len = 0;
+static cpu_set_t aff_node_set;
+
+typedef struct {
+    int cpu;
+    int package;
+    int core;
+    int thread;     // Index among the core's hardware threads
+} cpu_topo_t;
+
+// "0-3,8,10-11" -> set; returns the number of CPUs added
+static int parse_cpulist(const char *list, cpu_set_t *set) {
+    int added = 0;
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p) break;
+        if (*end == '-') hi = strtol(end + 1, &end, 10);
+        for (long c = lo; c <= hi && c < CPU_SETSIZE; c++, added++) CPU_SET(c, set);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return added;
+}
+
+// First line of a sysfs file into buf, -1 if unreadable
+static int read_sysfs(const char *path, char *buf, size_t len) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    int ok = fgets(buf, len, fp) != NULL;
+    fclose(fp);
+    return ok ? 0 : -1;
+}
+
+static int read_topology(int cpu, cpu_topo_t *t) {
+    char path[128], buf[256];
+    t->cpu = cpu;
+    t->package = t->core = t->thread = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    if (read_sysfs(path, buf, sizeof(buf)) == 0) t->package = atoi(buf);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+    if (read_sysfs(path, buf, sizeof(buf)) == 0) t->core = atoi(buf);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    if (read_sysfs(path, buf, sizeof(buf)) == 0) {
+        cpu_set_t siblings;
+        CPU_ZERO(&siblings);
+        parse_cpulist(buf, &siblings);
+        for (int c = 0; c < cpu; c++) t->thread += CPU_ISSET(c, &siblings) ? 1 : 0;
+    }
+    return 0;
+}
+
+static int topo_cmp_smt(const void *a, const void *b) {
+    const cpu_topo_t *x = a, *y = b;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->thread - y->thread;
+}
+
+// Order for spread: first hardware thread of every core, cores of different
+// packages interleaved (core rank within package, then package)
+static int topo_cmp_spread(const void *a, const void *b) {
+    const cpu_topo_t *x = a, *y = b;
+    if (x->thread != y->thread) return x->thread - y->thread;
+    if (x->core != y->core) return x->core - y->core;
+    return x->package - y->package;
+}
+
+int select_affinity(const char *spec) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s", spec);
+    char *colon = strchr(name, ':');
+    if (colon) {
+        *colon = '\0';
+        aff_arg = atoi(colon + 1);
+    }
+    int p = find_name(aff_policy_names, AFF_PAIR + 1, name);
+    if (p < 0) {
+        fprintf(stderr, "Unknown affinity policy: %s\n", spec);
+        return -1;
+    }
+    aff_policy = (aff_policy_t)p;
+    return 0;
+}
+
+int affinity_setup(void) {
+    if (aff_policy == AFF_NONE) return 0;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        perror("sched_getaffinity failed");
+        return -1;
+    }
+
+    if (aff_policy == AFF_NUMA) {
+        char path[128], buf[1024];
+        int node = aff_arg < 0 ? 0 : aff_arg;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        CPU_ZERO(&aff_node_set);
+        if (read_sysfs(path, buf, sizeof(buf)) < 0 || parse_cpulist(buf, &aff_node_set) == 0) {
+            fprintf(stderr, "Cannot read the CPUs of NUMA node %d\n", node);
+            return -1;
+        }
+        CPU_AND(&aff_node_set, &aff_node_set, &allowed);
+        if (CPU_COUNT(&aff_node_set) == 0) {
+            fprintf(stderr, "No allowed CPUs on NUMA node %d\n", node);
+            return -1;
+        }
+        return 0;
+    }
+
+    cpu_topo_t *topo = malloc(sizeof(cpu_topo_t) * CPU_SETSIZE);
+    aff_plan = malloc(sizeof(int) * CPU_SETSIZE);
+    if (!topo || !aff_plan) {
+        free(topo);
+        return -1;
+    }
+    int n = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &allowed)) read_topology(c, &topo[n++]);
+    }
+
+    if (aff_policy == AFF_SINGLE) {
+        int cpu = aff_arg < 0 ? topo[0].cpu : aff_arg;
+        if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+            fprintf(stderr, "CPU %d is not allowed\n", cpu);
+            free(topo);
+            return -1;
+        }
+        aff_plan[0] = cpu;
+        aff_plan_len = 1;
+    } else {
+        if (aff_policy == AFF_SMT) qsort(topo, n, sizeof(cpu_topo_t), topo_cmp_smt);
+        if (aff_policy == AFF_SPREAD || aff_policy == AFF_PAIR) qsort(topo, n, sizeof(cpu_topo_t), topo_cmp_spread);
+        for (int i = 0; i < n; i++) aff_plan[i] = topo[i].cpu;
+        aff_plan_len = n;
+    }
+    free(topo);
+    return 0;
+}
+
+void affinity_apply(int id) {
+    if (aff_policy == AFF_NONE) return;
+
+    cpu_set_t set;
+    if (aff_policy == AFF_NUMA) set = aff_node_set;
+    else {
+        CPU_ZERO(&set);
+        int slot = aff_policy == AFF_PAIR ? id / 2 : id;
+        CPU_SET(aff_plan[slot % aff_plan_len], &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) perror("sched_setaffinity failed");
+}
+
+const char *affinity_label(void) {
+    return aff_policy_names[aff_policy];
+}
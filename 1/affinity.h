@@ -0,0 +1,29 @@
+// CPU affinity. Each worker pins itself with sched_setaffinity() before it
+// starts. Plans only use CPUs the program was allowed to run on.
+//   none          - no pinning (default)
+//   single[:cpu]  - every worker on one CPU (first allowed CPU by default)
+//   compact       - worker i on the i-th allowed CPU in numbering order
+//   spread        - one worker per physical core, packages round-robin,
+//                   before any core gets a second worker
+//   smt           - fill every hardware thread of a core before the next
+//   numa[:node]   - every worker may run on any CPU of the node (default 0)
+//   pair          - like spread, but workers 2k and 2k+1 share the k-th CPU
+// Workers beyond the number of CPUs in a plan wrap around.
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include "common.h"
+
+// "spread", "single:3", "numa:1"; returns -1 for an unknown policy
+int select_affinity(const char *spec);
+
+// Build the plan from the CPUs this process may use; call before creating workers
+int affinity_setup(void);
+
+// Pin the calling process/thread as worker id of the plan
+void affinity_apply(int id);
+
+// Name of the selected policy, for reports
+const char *affinity_label(void);
+
+#endif
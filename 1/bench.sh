@@ -1,11 +1,82 @@
 #!/bin/bash
 
+# Usage: ./bench.sh [weak|strong|simd|membw|pages|ioeng|shared|affinity|sync|ipc|pingpong|scale|hybrid|noise|cgroup|spawn|all]
+#   weak   - every worker repeats the full job (default, results.csv)
+#   strong - one fixed job split across N workers (strong_scaling.csv)
+#   simd   - cpu job GFLOP/s per compute kernel and worker count (simd.csv)
+#   membw  - STREAM bandwidth / chase latency per worker count (membw.csv)
+#            and the working-set/stride sweep (mem_sweep.csv)
+#   pages  - page size / prefault / copy-on-write study (mem_pages.csv)
+#   ioeng  - I/O engine x sync policy x block size (io_engines.csv)
+#   shared - all workers committing to one file (shared_file.csv)
+#   affinity - placement policies x worker counts (affinity.csv)
+#   sync   - shared-counter coordination cost per variant (sync.csv)
+#   ipc    - producer/consumer throughput per transport, record size and
+#            pair count (ipc.csv)
+#   pingpong - token round-trip latency per wake mechanism, placement and
+#            pair count (pingpong.csv, histograms in pingpong_hist.csv)
+#   scale  - idle/light workers up to thousands: creation/teardown time and
+#            per-worker PSS, page tables, kernel memory (scale.csv)
+#   hybrid - every P x T factorization of N for each worker (hybrid.csv)
+#   noise  - fixed-work-quantum jitter per worker count and placement
+#            (noise.csv, largest interruptions in noise_top.csv)
+#   cgroup - cpu/mem/io workers inside a temporary cgroup v2 under cpu.max,
+#            memory.max and io.max limits, with throttling/PSI (cgroup.csv)
+#   spawn  - spawn latency per primitive and parent RSS (spawn.csv)
+MODE=${1:-weak}
+
 # CONFIG
-DISK_DEVICE="sdd"  
-CPU_CORE=0         
+CPU_CORE=0
+STATS_FILE="worker_stats.csv"
+MEM_TOTAL_KB=$(awk '/^MemTotal:/ {print $2}' /proc/meminfo)
+STRONG_COUNTS=(1 2 4 8)
+STRONG_CHUNKS=256
+SIMD_KERNELS=(scalar multi autovec sse avx2 avx512)
+SIMD_COUNTS=(1 2 4 8)
+MEMBW_KERNELS=(copy scale add triad chase)
+MEMBW_COUNTS=(1 2 4 8)
+SWEEP_COUNTS=(1 4)
+PAGE_MODES=(4k thp hugetlb 4k+populate thp+populate hugetlb+populate)
+PAGE_KERNELS=(touch cowread cowwrite)
+PAGE_COUNTS=(1 4)
+COW_MB=512
+IO_ENGINES=(stdio pwrite pwritev direct uring mmap)
+IO_SYNCS=(fsync fdatasync sync_file_range none)
+IO_BLOCKS=(4096 65536)
+IO_DEPTH=16
+IO_COUNTS=(1 4)
+SHARE_MODES=(append pwrite group)
+SHARE_COUNTS=(1 2 4 8)
+AFF_POLICIES=(single compact spread smt numa)
+AFF_COUNTS=(1 2 4 8)
+SYNC_VARIANTS=(mutex spin futex atomic padded false)
+SYNC_COUNTS=(1 2 4 8)
+IPC_TRANSPORTS=(pipe vmsplice unix seqpacket ring queue)
+IPC_RECORDS=(64 4096 65536)
+IPC_PAIRS=(1 2 4)
+PING_MECHS=(futex eventfd pipe condvar futex+spin eventfd+spin pipe+spin condvar+spin)
+PING_PLACEMENTS=(none pair spread)
+PING_PAIRS=(1 2 4 8)
+SCALE_WORKERS=(idle light)
+SCALE_COUNTS=(16 64 256 1024 2048 4096)
+SCALE_STACKS_KB=(0 1024 64)
+HYBRID_WORKERS=(cpu mem io sync)
+HYBRID_COUNTS=(8 16)
+NOISE_POLICIES=(none spread)
+NOISE_COUNTS=(1 2 4 8)
+SPAWN_PRIMS=(fork vfork posix_spawn clone)
+SPAWN_RSS_MB=(4 64 512 2048)
+SPAWN_SAMPLES=200
+# cgroup v2 mode (needs root and a v2 hierarchy with the controllers enabled)
+CG_ROOT=${CG_ROOT:-/sys/fs/cgroup}
+CG_CPU_MAXES=("max 100000" "50000 100000" "25000 100000")  # quota period (us)
+CG_CPU_WEIGHT=100
+CG_MEM_MAXES=(max 1G 512M 256M)
+CG_IO_MAXES=(max)   # e.g. "8:0 wbps=10485760 wiops=1000" (see lsblk MAJ:MIN)
+CG_COUNTS=(2 4 8)
 
-# Initialize CSV
-echo "Program,Function,Count,CPU%,Mem%,IO(MB/s),Time(s)" > results.csv
+# Per-worker and per-run rows written by the programs themselves
+rm -f "$STATS_FILE"
 
 run_benchmark() {
     local prog=$1
@@ -14,64 +85,471 @@ run_benchmark() {
     
     echo "Running $prog $worker with count $count..."
     
-    # Start Program pinned to core 0
-    (time taskset -c $CPU_CORE ./$prog $worker $count) > /dev/null 2> temp_time.log &
-    PID=$!
-    
-    # Wait a moment for processes to spawn
-    sleep 0.5
-
-    # Reset logs
-    > temp_io.log
-    > temp_top.log
-    
-    # Monitoring Loop
-    while kill -0 $PID 2> /dev/null; do
-        # 1. CPU/MEM (TOP)
-        # Grep by Name (-w matches whole word) to catch Parent AND Children
-        top -b -n 1 | grep -w "$prog" | awk '{c+=$9; m+=$10} END {print c, m}' >> temp_top.log
-        
-        # 2. IO (IOSTAT - System Wide)
-        # This captures ALL writes to 'sdd', ensuring we see Child processes too.
-        # We take 2 samples, keep the last one (tail -1) to avoid the "boot average" error.
-        iostat -d -k 1 2 | grep "$DISK_DEVICE" | tail -n 1 | awk '{print $4/1024}' >> temp_io.log
-        
-        sleep 1
-    done
+    # Every worker pins itself to core 0 (sched_setaffinity). The program
+    # measures itself (getrusage, /proc/<pid>/task/<tid>/io) and appends
+    # its rows to the stats file.
+    ./$prog -o "$STATS_FILE" -a single:$CPU_CORE $worker $count > /dev/null
 
-    # Calculate Averages
-    avg_cpu=$(awk '{sum+=$1; n++} END {if (n>0) print sum/n; else print 0}' temp_top.log)
-    avg_mem=$(awk '{sum+=$2; n++} END {if (n>0) print sum/n; else print 0}' temp_top.log)
-    avg_io=$(awk '{sum+=$1; n++} END {if (n>0) print sum/n; else print 0}' temp_io.log)
-    
-    # Extract Time
-    real_time_raw=$(grep "real" temp_time.log | awk '{print $2}')
-    min=$(echo $real_time_raw | cut -d'm' -f1)
-    sec=$(echo $real_time_raw | cut -d'm' -f2 | cut -d's' -f1)
-    total_sec=$(echo "$min * 60 + $sec" | bc)
+    # The last row is this run's aggregate ("run" scope):
+    # wall_s=$10 cpu_pct=$13 maxrss_kb=$14 write_bytes=$20
+    local row=$(tail -n 1 "$STATS_FILE")
+    local total_sec=$(echo "$row" | awk -F, '{print $10}')
+    local avg_cpu=$(echo "$row" | awk -F, '{print $13}')
+    local avg_mem=$(echo "$row" | awk -F, -v total="$MEM_TOTAL_KB" '{printf "%.2f", 100 * $14 / total}')
+    local avg_io=$(echo "$row" | awk -F, '{if ($10 > 0) printf "%.3f", $20 / 1048576 / $10; else print 0}')
 
     # Save to CSV
     echo "$prog,$worker,$count,$avg_cpu,$avg_mem,$avg_io,$total_sec" >> results.csv
 }
 
+# Strong scaling: time one fixed job on N workers and report speedup
+# T(1)/T(N) and parallel efficiency speedup/N. Not pinned, so the job can
+# actually spread over cores.
+run_strong() {
+    echo "Program,Function,Count,Chunks,Time(s),Speedup,Efficiency" > strong_scaling.csv
+
+    for prog in progA progB; do
+        for worker in "${WORKERS[@]}"; do
+            local t1=""
+            for count in "${STRONG_COUNTS[@]}"; do
+                echo "Running $prog $worker strong scaling with count $count..."
+                # STRONG,<program>,<worker>,<N>,<chunks>,<wall_s>[,<steals>]
+                local line=$(./$prog -o "$STATS_FILE" -S -c $STRONG_CHUNKS $worker $count | grep "^STRONG,")
+                local t=$(echo "$line" | cut -d',' -f6)
+                [ -z "$t1" ] && t1=$t
+                awk -v p=$prog -v w=$worker -v n=$count -v c=$STRONG_CHUNKS -v t=$t -v t1=$t1 \
+                    'BEGIN {s = t1 / t; printf "%s,%s,%d,%d,%.6f,%.3f,%.3f\n", p, w, n, c, t, s, s / n}' \
+                    >> strong_scaling.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# SIMD: GFLOP/s of each cpu kernel as workers are added. GFLOPS/worker falls
+# when workers share a core (SMT) or wide vectors lower the clock; Scaling
+# is GFLOPS/worker at N over N = 1. Kernels the CPU lacks are skipped.
+run_simd() {
+    echo "Program,Kernel,Count,GFLOPS/worker,GFLOPS,Scaling" > simd.csv
+
+    for prog in progA progB; do
+        for kernel in "${SIMD_KERNELS[@]}"; do
+            local p1=""
+            for count in "${SIMD_COUNTS[@]}"; do
+                echo "Running $prog cpu kernel $kernel with count $count..."
+                # GFLOPS,<program>,<kernel>,<N>,<id>,<cpu>,<gflops>
+                local out
+                out=$(./$prog -o "$STATS_FILE" -k $kernel cpu $count 2>/dev/null) || break
+                local per=$(echo "$out" | awk -F, '/^GFLOPS,/ && $5 >= 0 {s += $7; n++} END {printf "%.3f", s / n}')
+                local total=$(echo "$out" | awk -F, '/^GFLOPS,/ && $5 == -1 {print $7}')
+                [ -z "$p1" ] && p1=$per
+                awk -v p=$prog -v k=$kernel -v n=$count -v per=$per -v t=$total -v p1=$p1 \
+                    'BEGIN {printf "%s,%s,%d,%.3f,%.3f,%.3f\n", p, k, n, per, t, per / p1}' >> simd.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# Memory bandwidth and latency: aggregate GB/s flattens where bandwidth
+# saturates; ns/access is the time per access seen by one worker.
+run_membw() {
+    echo "Program,Kernel,Count,GB/s/worker,GB/s,ns/access" > membw.csv
+    echo "Program,Count,Worker,Test,Bytes,Stride,ns/access,GB/s" > mem_sweep.csv
+
+    for prog in progA progB; do
+        for kernel in "${MEMBW_KERNELS[@]}"; do
+            for count in "${MEMBW_COUNTS[@]}"; do
+                echo "Running $prog mem kernel $kernel with count $count..."
+                # MEMBW,<program>,<kernel>,<N>,<id>,<cpu>,<GB/s>,<ns/access>
+                ./$prog -o "$STATS_FILE" -m $kernel mem $count | awk -F, '
+                    /^MEMBW,/ && $5 >= 0 {s += $7; n++}
+                    /^MEMBW,/ && $5 == -1 {p = $2; k = $3; c = $4; t = $7; ns = $8}
+                    END {printf "%s,%s,%d,%.3f,%.3f,%.3f\n", p, k, c, s / n, t, ns}' >> membw.csv
+                sleep 1
+            done
+        done
+
+        for count in "${SWEEP_COUNTS[@]}"; do
+            echo "Running $prog mem sweep with count $count..."
+            # MEMSWEEP,<program>,<N>,<id>,<test>,<bytes>,<stride>,<ns/access>,<GB/s>
+            ./$prog -o "$STATS_FILE" -m sweep mem $count | grep "^MEMSWEEP," | cut -d',' -f2- >> mem_sweep.csv
+            sleep 1
+        done
+    done
+}
+
+# Page size and copy-on-write: faults, page-table memory (VmPTE) and time
+# per worker (averaged), plus what the parent paid to map, touch and fork
+# a COW_MB buffer. hugetlb rows need vm.nr_hugepages and are skipped without.
+run_pages() {
+    echo "Program,Kernel,Pages,Count,MinFlt/worker,PTE_KB,THP_KB,Work(s),Setup(s),Spawn(s)" > mem_pages.csv
+
+    for prog in progA progB; do
+        for pages in "${PAGE_MODES[@]}"; do
+            for kernel in "${PAGE_KERNELS[@]}"; do
+                for count in "${PAGE_COUNTS[@]}"; do
+                    echo "Running $prog mem $kernel with $pages pages and count $count..."
+                    # MEMPAGE,<program>,<kernel>,<pages>,<N>,<id>,<minflt>,<majflt>,<pte_kb>,<thp_kb>,<work_s>
+                    # MEMSETUP,<program>,<pages>,<N>,<buf_mb>,<minflt>,<pte_kb>,<thp_kb>,<touch_s>,<spawn_s>
+                    ./$prog -o "$STATS_FILE" -g $pages -m $kernel -b $COW_MB mem $count 2>/dev/null | awk -F, '
+                        /^MEMPAGE,/ {p = $2; k = $3; g = $4; c = $5; f += $7; pte += $9; thp += $10; t += $11; n++}
+                        /^MEMSETUP,/ {setup = $9; spawn = $10}
+                        END {if (n) printf "%s,%s,%s,%d,%.0f,%.0f,%.0f,%.6f,%.6f,%.6f\n",
+                             p, k, g, c, f / n, pte / n, thp / n, t / n, setup, spawn}' >> mem_pages.csv
+                    sleep 1
+                done
+            done
+        done
+    done
+}
+
+# I/O engines: aggregate MB/s and IOPS, sync latency percentiles of the
+# worst worker. Files are written in the current directory.
+run_ioeng() {
+    echo "Program,Engine,Sync,Block,Depth,Count,MB/s,IOPS,Syncs,p50_us,p99_us,max_us" > io_engines.csv
+
+    for prog in progA progB; do
+        for engine in "${IO_ENGINES[@]}"; do
+            for sync in "${IO_SYNCS[@]}"; do
+                for block in "${IO_BLOCKS[@]}"; do
+                    for count in "${IO_COUNTS[@]}"; do
+                        echo "Running $prog io $engine/$sync with ${block}B blocks and count $count..."
+                        # IOENG,<program>,<engine>,<sync>,<block>,<depth>,<N>,<id>,<MB/s>,<IOPS>,<syncs>,<p50_us>,<p99_us>,<max_us>
+                        ./$prog -o "$STATS_FILE" -e $engine -s $sync -B $block -q $IO_DEPTH io $count |
+                            awk -F, '/^IOENG,/ && $8 == -1' | cut -d',' -f2-7,9- >> io_engines.csv
+                        sleep 1
+                    done
+                done
+            done
+        done
+    done
+}
+
+# Shared-file contention: per-record commit latency (worst worker) and
+# aggregate commit throughput; Syncs against N x 2000 records shows how well
+# group commit batches.
+run_shared() {
+    echo "Program,Mode,Count,Records/s,MB/s,p50_us,p99_us,max_us,Syncs" > shared_file.csv
+
+    for prog in progA progB; do
+        for mode in "${SHARE_MODES[@]}"; do
+            for count in "${SHARE_COUNTS[@]}"; do
+                echo "Running $prog io shared-file $mode with count $count..."
+                # SHARED,<program>,<mode>,<N>,<id>,<records/s>,<MB/s>,<p50_us>,<p99_us>,<max_us>,<syncs>
+                ./$prog -o "$STATS_FILE" -W $mode io $count |
+                    awk -F, '/^SHARED,/ && $5 == -1' | cut -d',' -f2-4,6- >> shared_file.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# Placement: each worker applies the policy itself. CPUs is the number of
+# distinct CPUs the workers last ran on, from this run's worker rows.
+run_affinity() {
+    echo "Program,Function,Policy,Count,Time(s),CPU%,CPUs" > affinity.csv
+
+    for prog in progA progB; do
+        for worker in "${WORKERS[@]}"; do
+            for policy in "${AFF_POLICIES[@]}"; do
+                for count in "${AFF_COUNTS[@]}"; do
+                    echo "Running $prog $worker with $policy affinity and count $count..."
+                    ./$prog -o "$STATS_FILE" -a $policy $worker $count > /dev/null || continue
+                    # Run row: run_id=$1 wall_s=$10 cpu_pct=$13; worker rows: scope=$5 cpu=$9
+                    local row=$(tail -n 1 "$STATS_FILE")
+                    local run_id=$(echo "$row" | cut -d',' -f1)
+                    local cpus=$(awk -F, -v id="$run_id" '$1 == id && $5 == "worker" {print $9}' "$STATS_FILE" | sort -u | wc -l)
+                    echo "$row" | awk -F, -v p=$prog -v w=$worker -v a=$policy -v n=$count -v c=$cpus \
+                        '{printf "%s,%s,%s,%d,%s,%s,%d\n", p, w, a, n, $10, $13, c}' >> affinity.csv
+                    sleep 1
+                done
+            done
+        done
+    done
+}
+
+# Coordination cost: aggregate increments/s of the shared state per variant.
+# Not pinned, so contention is between cores rather than time slices.
+run_sync() {
+    echo "Program,Variant,Count,Ops/s,ns/op" > sync.csv
+
+    for prog in progA progB; do
+        for variant in "${SYNC_VARIANTS[@]}"; do
+            for count in "${SYNC_COUNTS[@]}"; do
+                echo "Running $prog sync $variant with count $count..."
+                # SYNC,<program>,<variant>,<N>,<id>,<ops/s>,<ns/op>
+                ./$prog -o "$STATS_FILE" -y $variant sync $count |
+                    awk -F, '/^SYNC,/ && $5 == -1' | cut -d',' -f2-4,6- >> sync.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# Producer/consumer pairs streaming fixed-size records over each transport.
+# The count is the number of pairs, so each run starts 2N workers.
+run_ipc() {
+    echo "Program,Transport,Record,Pairs,Records/s,GB/s" > ipc.csv
+
+    for prog in progA progB; do
+        for transport in "${IPC_TRANSPORTS[@]}"; do
+            for record in "${IPC_RECORDS[@]}"; do
+                for pairs in "${IPC_PAIRS[@]}"; do
+                    echo "Running $prog ipc $transport ${record}B with $pairs pairs..."
+                    # IPC,<program>,<transport>,<record>,<pairs>,<pair>,<records/s>,<GB/s>
+                    ./$prog -o "$STATS_FILE" -t $transport -r $record ipc $pairs |
+                        awk -F, '/^IPC,/ && $6 == -1' | cut -d',' -f2-5,7- >> ipc.csv
+                    sleep 1
+                done
+            done
+        done
+    done
+}
+
+# Token ping-pong between pairs: -a pair keeps both sides on one CPU (every
+# wakeup is a context switch), -a spread puts them on different cores.
+run_pingpong() {
+    echo "Program,Mechanism,Placement,Pairs,RoundTrips/s,p50_us,p99_us,p999_us,Max_us" > pingpong.csv
+    echo "Program,Mechanism,Placement,Pairs,Low_us,High_us,Count" > pingpong_hist.csv
+
+    for prog in progA progB; do
+        for mech in "${PING_MECHS[@]}"; do
+            for place in "${PING_PLACEMENTS[@]}"; do
+                for pairs in "${PING_PAIRS[@]}"; do
+                    echo "Running $prog pingpong $mech ($place) with $pairs pairs..."
+                    # PINGPONG,<program>,<mech>,<placement>,<pairs>,<pair>,<rt/s>,<p50>,<p99>,<p999>,<max>
+                    # PINGHIST,<program>,<mech>,<placement>,<pairs>,<low_us>,<high_us>,<count>
+                    ./$prog -o "$STATS_FILE" -a $place -w $mech pingpong $pairs > temp_ping.log
+                    awk -F, '/^PINGPONG,/ && $6 == -1' temp_ping.log | cut -d',' -f2-5,7- >> pingpong.csv
+                    grep "^PINGHIST," temp_ping.log | cut -d',' -f2- >> pingpong_hist.csv
+                    rm -f temp_ping.log
+                    sleep 1
+                done
+            done
+        done
+    done
+}
+
+# Thousands of idle or lightly loaded workers. progB also varies the thread
+# stack size (0 = the default from ulimit -s). A run that hits ulimit -u or
+# threads-max reports the workers it managed to create.
+run_scale() {
+    echo "Program,Function,Count,Stack_KB,Create_ms,Teardown_ms,RSS_KB,PSS_KB,USS_KB,PTE_KB,KernelStack_KB,PageTables_KB,Slab_KB,PSS_per_worker_KB,Kernel_per_worker_KB" > scale.csv
+
+    for worker in "${SCALE_WORKERS[@]}"; do
+        for count in "${SCALE_COUNTS[@]}"; do
+            echo "Running progA $worker with count $count..."
+            # SCALE,<program>,<worker>,<N>,<stack_kb>,<create_ms>,<teardown_ms>,<rss>,<pss>,<uss>,<pte>,<kstack>,<ptables>,<slab>,<pss/worker>,<kernel/worker>
+            ./progA -o "$STATS_FILE" $worker $count | grep "^SCALE," | cut -d',' -f2- >> scale.csv
+            sleep 1
+            for stack in "${SCALE_STACKS_KB[@]}"; do
+                echo "Running progB $worker with count $count (stack ${stack}KB)..."
+                ./progB -o "$STATS_FILE" -z $stack $worker $count | grep "^SCALE," | cut -d',' -f2- >> scale.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# P processes x T threads = N workers, for every divisor T of N: T=1 is
+# pure processes (progA), T=N is one process of threads (like progB).
+run_hybrid() {
+    echo "Program,Function,Count,Processes,Threads,Time(s),Ops/s,MaxRSS_KB,nvcsw,nivcsw" > hybrid.csv
+
+    for worker in "${HYBRID_WORKERS[@]}"; do
+        for count in "${HYBRID_COUNTS[@]}"; do
+            for ((threads = 1; threads <= count; threads++)); do
+                (( count % threads == 0 )) || continue
+                echo "Running progA $worker with $((count / threads)) x $threads..."
+                # HYBRID,<program>,<worker>,<N>,<P>,<T>,<wall_s>,<ops/s>,<maxrss_kb>,<nvcsw>,<nivcsw>
+                ./progA -o "$STATS_FILE" -T $threads $worker $count | grep "^HYBRID," | cut -d',' -f2- >> hybrid.csv
+                sleep 1
+            done
+        done
+    done
+}
+
+# OS noise seen by a fixed work quantum. Run it on isolated CPUs (isolcpus,
+# nohz_full) with -a single:<cpu> to check the isolation.
+run_noise() {
+    echo "Program,Count,Policy,Min_us,p50_us,p99_us,p999_us,Max_us,Noise%,Migrations,nivcsw" > noise.csv
+    echo "Program,Count,Policy,Worker,Rank,At_ms,Sample_us,CPU" > noise_top.csv
+
+    for prog in progA progB; do
+        for policy in "${NOISE_POLICIES[@]}"; do
+            for count in "${NOISE_COUNTS[@]}"; do
+                echo "Running $prog fwq ($policy) with count $count..."
+                # FWQ,<program>,<N>,<id>,<min>,<p50>,<p99>,<p999>,<max>,<noise%>,<migrations>,<nivcsw>
+                # FWQTOP,<program>,<N>,<id>,<rank>,<at_ms>,<sample_us>,<cpu>
+                ./$prog -o "$STATS_FILE" -a $policy fwq $count > temp_fwq.log
+                awk -F, -v p=$policy 'BEGIN {OFS = ","} /^FWQ,/ && $4 == -1 {$4 = p; print}' temp_fwq.log |
+                    cut -d',' -f2- >> noise.csv
+                awk -F, -v p=$policy 'BEGIN {OFS = ","} /^FWQTOP,/ {$1 = ""; $3 = $3 "," p; print}' temp_fwq.log |
+                    cut -d',' -f2- >> noise_top.csv
+                rm -f temp_fwq.log
+                sleep 1
+            done
+        done
+    done
+}
+
+# --- CGROUP V2 ---
+CG_DIR=""
+
+# Write a limit; a new cgroup already starts at the default
+cg_set() {
+    local file=$1 value=$2 default=$3
+    [ "$value" = "$default" ] && return 0
+    if [ ! -w "$CG_DIR/$file" ]; then
+        echo "Cannot set $file (controller not enabled under $CG_ROOT)" >&2
+        return 1
+    fi
+    echo "$value" > "$CG_DIR/$file"
+}
+
+# key=value field of a flat-keyed cgroup file (cpu.stat, memory.events)
+cg_key() {
+    awk -v k="$2" '$1 == k {print $2; found = 1} END {if (!found) print 0}' "$CG_DIR/$1" 2>/dev/null || echo 0
+}
+
+# total= of the "some"/"full" line of a PSI file, in microseconds
+cg_psi() {
+    awk -v k="$2" '$1 == k {for (i = 2; i <= NF; i++) if ($i ~ /^total=/) print substr($i, 7)}' \
+        "$CG_DIR/$1" 2>/dev/null | grep . || echo 0
+}
+
+cg_create() {
+    CG_DIR="$CG_ROOT/bench.$$"
+    # Let children of the root use the controllers (ignored if already on)
+    for c in cpu memory io; do echo "+$c" > "$CG_ROOT/cgroup.subtree_control" 2>/dev/null; done
+    mkdir "$CG_DIR" || return 1
+    # No swap, so memory.max means reclaim and OOM rather than swapping
+    cg_set memory.swap.max 0 max 2>/dev/null
+    if ! cg_set cpu.max "$1" "max 100000" || ! cg_set cpu.weight "$CG_CPU_WEIGHT" 100 ||
+       ! cg_set memory.max "$2" max || ! cg_set io.max "$3" max; then
+        rmdir "$CG_DIR"
+        return 1
+    fi
+}
+
+# One run inside the cgroup: the shell joins it and execs the program, so
+# every forked worker and thread is charged to it from the start
+run_cgroup_one() {
+    local prog=$1 worker=$2 count=$3 cpu_max=$4 mem_max=$5 io_max=$6
+    echo "Running $prog $worker with count $count (cpu.max=$cpu_max memory.max=$mem_max io.max=$io_max)..."
+    cg_create "$cpu_max" "$mem_max" "$io_max" || return
+
+    local before=$(wc -l 2>/dev/null < "$STATS_FILE" || echo 0)
+    sh -c 'echo $$ > "$1/cgroup.procs" && shift && exec "$@"' sh "$CG_DIR" \
+        ./$prog -o "$STATS_FILE" $worker $count > /dev/null 2>&1
+    local status=$?
+
+    # Wall time from this run's row; an OOM-killed run writes no row
+    local secs=0
+    if [ "$(wc -l 2>/dev/null < "$STATS_FILE" || echo 0)" -gt "$before" ]; then
+        secs=$(tail -n 1 "$STATS_FILE" | awk -F, '{print $10}')
+    fi
+    echo "$prog,$worker,$count,${cpu_max// //},$CG_CPU_WEIGHT,$mem_max,${io_max// /;},$status,$secs,$(cg_key cpu.stat nr_periods),$(cg_key cpu.stat nr_throttled),$(cg_key cpu.stat throttled_usec),$(cg_key memory.events high),$(cg_key memory.events max),$(cg_key memory.events oom_kill),$(cg_key memory.stat pgmajfault),$(cg_psi cpu.pressure some),$(cg_psi memory.pressure some),$(cg_psi memory.pressure full),$(cg_psi io.pressure full)" >> cgroup.csv
+
+    rmdir "$CG_DIR"
+}
+
+# cpu worker under CPU quotas, mem worker under memory limits, io worker
+# under io.max; processes vs threads at each count
+run_cgroup() {
+    if [ ! -f "$CG_ROOT/cgroup.controllers" ]; then
+        echo "No cgroup v2 hierarchy at $CG_ROOT (set CG_ROOT)"
+        return 1
+    fi
+    echo "Program,Function,Count,cpu.max,cpu.weight,memory.max,io.max,Exit,Time(s),nr_periods,nr_throttled,throttled_us,mem_high,mem_max,oom_kill,pgmajfault,cpu_some_us,mem_some_us,mem_full_us,io_full_us" > cgroup.csv
+
+    for prog in progA progB; do
+        for count in "${CG_COUNTS[@]}"; do
+            for cpu_max in "${CG_CPU_MAXES[@]}"; do
+                run_cgroup_one $prog cpu $count "$cpu_max" max max
+                sleep 1
+            done
+            for mem_max in "${CG_MEM_MAXES[@]}"; do
+                run_cgroup_one $prog mem $count "max 100000" $mem_max max
+                sleep 1
+            done
+            for io_max in "${CG_IO_MAXES[@]}"; do
+                run_cgroup_one $prog io $count "max 100000" max "$io_max"
+                sleep 1
+            done
+        done
+    done
+}
+
+# Spawn cost from a parent with a growing touched RSS: fork copies the page
+# tables, vfork/posix_spawn/clone(CLONE_VM)/pthread_create do not.
+run_spawn() {
+    echo "Program,Primitive,Pages,RSS_MB,Samples,Start_p50_us,Start_p99_us,Start_max_us,Reap_p50_us,Reap_p99_us,Reap_max_us,PTE_KB" > spawn.csv
+
+    for rss in "${SPAWN_RSS_MB[@]}"; do
+        for prim in "${SPAWN_PRIMS[@]}"; do
+            echo "Running progA spawn $prim with ${rss}MB parent RSS..."
+            # SPAWN,<program>,<primitive>,<pages>,<rss_mb>,<n>,<start p50,p99,max>,<reap p50,p99,max>,<pte_kb>
+            ./progA -R $rss -p $prim spawn $SPAWN_SAMPLES | grep "^SPAWN," | cut -d',' -f2- >> spawn.csv
+            sleep 1
+        done
+        echo "Running progB spawn pthread with ${rss}MB parent RSS..."
+        ./progB -R $rss spawn $SPAWN_SAMPLES | grep "^SPAWN," | cut -d',' -f2- >> spawn.csv
+        sleep 1
+    done
+}
+
 # --- EXECUTION LOOPS ---
 
 WORKERS=("cpu" "mem" "io")
 
-# 1. Program A (Processes)
-for worker in "${WORKERS[@]}"; do
-    for count in 2 3 4 5; do
-        run_benchmark "progA" "$worker" "$count"
-        sleep 1
+run_weak() {
+    # Initialize CSV
+    echo "Program,Function,Count,CPU%,Mem%,IO(MB/s),Time(s)" > results.csv
+
+    # 1. Program A (Processes)
+    for worker in "${WORKERS[@]}"; do
+        for count in 2 3 4 5; do
+            run_benchmark "progA" "$worker" "$count"
+            sleep 1
+        done
     done
-done
 
-# 2. Program B (Threads)
-for worker in "${WORKERS[@]}"; do
-    for count in 2 3 4 5 6 7 8; do
-        run_benchmark "progB" "$worker" "$count"
-        sleep 1
+    # 2. Program B (Threads)
+    for worker in "${WORKERS[@]}"; do
+        for count in 2 3 4 5 6 7 8; do
+            run_benchmark "progB" "$worker" "$count"
+            sleep 1
+        done
     done
-done
+
+    # Append this run (with machine fingerprint) to the shared result store
+    python3 ../result_store.py record --kind part1 results.csv
+}
+
+case "$MODE" in
+    weak)   run_weak ;;
+    strong) run_strong ;;
+    simd)   run_simd ;;
+    membw)  run_membw ;;
+    pages)  run_pages ;;
+    ioeng)  run_ioeng ;;
+    shared) run_shared ;;
+    affinity) run_affinity ;;
+    sync)   run_sync ;;
+    ipc)    run_ipc ;;
+    pingpong) run_pingpong ;;
+    scale)  run_scale ;;
+    hybrid) run_hybrid ;;
+    noise)  run_noise ;;
+    cgroup) run_cgroup ;;
+    spawn)  run_spawn ;;
+    all)    run_weak; run_strong; run_simd; run_membw; run_pages; run_ioeng; run_shared; run_affinity
+            run_sync; run_ipc; run_pingpong; run_scale; run_hybrid; run_noise; run_cgroup; run_spawn ;;
+    *)      echo "Usage: $0 [weak|strong|simd|membw|pages|ioeng|shared|affinity|sync|ipc|pingpong|scale|hybrid|noise|cgroup|spawn|all]"; exit 1 ;;
+esac
+
+python3 ../result_store.py record --kind part1-stats "$STATS_FILE"
 
 echo "Benchmark Complete. Generating Plots..."
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "common.h"
+#include <sys/syscall.h>
+
+double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int find_name(const char *const *names, int n, const char *name) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double percentile(const double *v, long n, double q) {
+    if (n == 0) return 0.0;
+    long k = (long)(q * n);
+    if (k < q * n) k++; // ceil
+    return v[k > 0 ? k - 1 : 0];
+}
+
+long read_proc_kb(const char *path, const char *key) {
+    char line[256];
+    long value = -1;
+    size_t len = strlen(key);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, key, len) == 0 && line[len] == ':') {
+            value = atol(line + len + 1);
+            break;
+        }
+    }
+    fclose(fp);
+    return value;
+}
+
+long futex_op(int *uaddr, int op, int val) {
+    return syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+}
+
+void make_run_id(char *buf, size_t len) {
+    snprintf(buf, len, "%ld-%d", (long)time(NULL), getpid());
+}
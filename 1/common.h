@@ -0,0 +1,49 @@
+// Shared by A.c (processes), B.c (threads) and the job modules: job
+// definitions and small helpers
+#ifndef COMMON_H
+#define COMMON_H
+
+#define _GNU_SOURCE // RUSAGE_THREAD
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+// --- JOB DEFINITIONS ---
+// One worker's job in the default (weak scaling) mode. Strong scaling
+// splits exactly one such job into chunks shared by all workers.
+#define CPU_OUTER_ITERS (8*300)
+#define CPU_INNER_ITERS 100000
+#define MEM_SIZE (100L * 1024 * 1024) // 100MB
+#define MEM_PAGE 4096
+#define MEM_PASSES (8*400)
+#define IO_RECORDS 80000
+#define IO_RECORD_SIZE 1024
+#define IO_SYNC_EVERY 1000
+
+#define CACHE_LINE 64
+
+typedef enum { JOB_CPU, JOB_MEM, JOB_IO, JOB_SYNC, JOB_IPC, JOB_PING, JOB_SCALE, JOB_FWQ } job_kind_t;
+
+// CLOCK_MONOTONIC in seconds
+double now_sec(void);
+
+// Index of name in names[0..n), -1 if absent
+int find_name(const char *const *names, int n, const char *name);
+
+int cmp_double(const void *a, const void *b);
+
+// Nearest-rank percentile of sorted v[0..n)
+double percentile(const double *v, long n, double q);
+
+// A "<key> <n> kB" line from a /proc file, -1 if missing
+long read_proc_kb(const char *path, const char *key);
+
+long futex_op(int *uaddr, int op, int val);
+
+// "<unix time>-<pid>", shared by all rows of one run
+void make_run_id(char *buf, size_t len);
+
+#endif
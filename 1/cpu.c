@@ -0,0 +1,216 @@
+#include "cpu.h"
+
+#define CPU_FLOPS_PER_ELEM 3
+
+// Result of the last kernel call, so the compiler cannot drop the work
+static volatile double cpu_sink;
+
+// Today's loop: one dependent add chain through memory (volatile)
+static double cpu_kernel_scalar(long begin, long end) {
+    volatile double result = 0.0;
+    for (long k = begin; k < end; k++) {
+        for (long i = 0; i < CPU_INNER_ITERS; i++) result += (i * 0.001) + (k * 0.1);
+    }
+    return result;
+}
+
+// Eight independent scalar accumulators: hides the add latency, no SIMD
+__attribute__((optimize("no-tree-vectorize")))
+static double cpu_kernel_multi(long begin, long end) {
+    double acc[8] = {0};
+    for (long k = begin; k < end; k++) {
+        double kc = k * 0.1;
+        long i = 0;
+        for (; i + 8 <= CPU_INNER_ITERS; i += 8) {
+            for (int j = 0; j < 8; j++) acc[j] += ((i + j) * 0.001) + kc;
+        }
+        for (; i < CPU_INNER_ITERS; i++) acc[0] += (i * 0.001) + kc;
+    }
+    double sum = 0.0;
+    for (int j = 0; j < 8; j++) sum += acc[j];
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_KERNELS_X86 1
+
+// Plain loop; reassociation lets the compiler split the sum into vector
+// lanes. target_clones builds one copy per ISA and picks at load time.
+__attribute__((optimize("O3", "associative-math", "no-signed-zeros", "no-trapping-math")))
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static double cpu_kernel_autovec(long begin, long end) {
+    double result = 0.0;
+    for (long k = begin; k < end; k++) {
+        double kc = k * 0.1;
+        // int index: int -> double converts in vector lanes, long needs AVX-512DQ
+        for (int i = 0; i < CPU_INNER_ITERS; i++) result += (i * 0.001) + kc;
+    }
+    return result;
+}
+
+// Explicit SIMD: four vector accumulators, the index vector advanced by adds
+__attribute__((target("sse2")))
+static double cpu_kernel_sse(long begin, long end) {
+    const __m128d scale = _mm_set1_pd(0.001), step4 = _mm_set1_pd(8.0);
+    double sum = 0.0;
+    for (long k = begin; k < end; k++) {
+        __m128d kc = _mm_set1_pd(k * 0.1);
+        __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+        __m128d i0 = _mm_set_pd(1, 0), i1 = _mm_set_pd(3, 2);
+        __m128d i2 = _mm_set_pd(5, 4), i3 = _mm_set_pd(7, 6);
+        long i = 0;
+        for (; i + 8 <= CPU_INNER_ITERS; i += 8) {
+            a0 = _mm_add_pd(a0, _mm_add_pd(_mm_mul_pd(i0, scale), kc));
+            a1 = _mm_add_pd(a1, _mm_add_pd(_mm_mul_pd(i1, scale), kc));
+            a2 = _mm_add_pd(a2, _mm_add_pd(_mm_mul_pd(i2, scale), kc));
+            a3 = _mm_add_pd(a3, _mm_add_pd(_mm_mul_pd(i3, scale), kc));
+            i0 = _mm_add_pd(i0, step4);
+            i1 = _mm_add_pd(i1, step4);
+            i2 = _mm_add_pd(i2, step4);
+            i3 = _mm_add_pd(i3, step4);
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)));
+        sum += lanes[0] + lanes[1];
+        for (; i < CPU_INNER_ITERS; i++) sum += (i * 0.001) + (k * 0.1);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static double cpu_kernel_avx2(long begin, long end) {
+    const __m256d scale = _mm256_set1_pd(0.001), step4 = _mm256_set1_pd(16.0);
+    double sum = 0.0;
+    for (long k = begin; k < end; k++) {
+        __m256d kc = _mm256_set1_pd(k * 0.1);
+        __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+        __m256d i0 = _mm256_set_pd(3, 2, 1, 0), i1 = _mm256_set_pd(7, 6, 5, 4);
+        __m256d i2 = _mm256_set_pd(11, 10, 9, 8), i3 = _mm256_set_pd(15, 14, 13, 12);
+        long i = 0;
+        for (; i + 16 <= CPU_INNER_ITERS; i += 16) {
+            a0 = _mm256_add_pd(a0, _mm256_fmadd_pd(i0, scale, kc));
+            a1 = _mm256_add_pd(a1, _mm256_fmadd_pd(i1, scale, kc));
+            a2 = _mm256_add_pd(a2, _mm256_fmadd_pd(i2, scale, kc));
+            a3 = _mm256_add_pd(a3, _mm256_fmadd_pd(i3, scale, kc));
+            i0 = _mm256_add_pd(i0, step4);
+            i1 = _mm256_add_pd(i1, step4);
+            i2 = _mm256_add_pd(i2, step4);
+            i3 = _mm256_add_pd(i3, step4);
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        for (; i < CPU_INNER_ITERS; i++) sum += (i * 0.001) + (k * 0.1);
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static double cpu_kernel_avx512(long begin, long end) {
+    const __m512d scale = _mm512_set1_pd(0.001), step4 = _mm512_set1_pd(32.0);
+    double sum = 0.0;
+    for (long k = begin; k < end; k++) {
+        __m512d kc = _mm512_set1_pd(k * 0.1);
+        __m512d a0 = _mm512_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+        __m512d i0 = _mm512_set_pd(7, 6, 5, 4, 3, 2, 1, 0);
+        __m512d i1 = _mm512_add_pd(i0, _mm512_set1_pd(8.0));
+        __m512d i2 = _mm512_add_pd(i0, _mm512_set1_pd(16.0));
+        __m512d i3 = _mm512_add_pd(i0, _mm512_set1_pd(24.0));
+        long i = 0;
+        for (; i + 32 <= CPU_INNER_ITERS; i += 32) {
+            a0 = _mm512_add_pd(a0, _mm512_fmadd_pd(i0, scale, kc));
+            a1 = _mm512_add_pd(a1, _mm512_fmadd_pd(i1, scale, kc));
+            a2 = _mm512_add_pd(a2, _mm512_fmadd_pd(i2, scale, kc));
+            a3 = _mm512_add_pd(a3, _mm512_fmadd_pd(i3, scale, kc));
+            i0 = _mm512_add_pd(i0, step4);
+            i1 = _mm512_add_pd(i1, step4);
+            i2 = _mm512_add_pd(i2, step4);
+            i3 = _mm512_add_pd(i3, step4);
+        }
+        sum += _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3)));
+        for (; i < CPU_INNER_ITERS; i++) sum += (i * 0.001) + (k * 0.1);
+    }
+    return sum;
+}
+#endif
+
+typedef double (*cpu_kernel_fn)(long begin, long end);
+
+// Instruction set an explicit kernel needs
+typedef enum { ISA_NONE, ISA_SSE2, ISA_AVX2, ISA_AVX512 } cpu_isa_t;
+
+static int cpu_isa_supported(cpu_isa_t isa) {
+#ifdef CPU_KERNELS_X86
+    __builtin_cpu_init();
+    if (isa == ISA_SSE2) return __builtin_cpu_supports("sse2");
+    if (isa == ISA_AVX2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (isa == ISA_AVX512) return __builtin_cpu_supports("avx512f");
+#endif
+    return isa == ISA_NONE;
+}
+
+static cpu_kernel_fn cpu_kernel = cpu_kernel_scalar;
+const char *cpu_kernel_name = "scalar";
+
+int select_cpu_kernel(const char *name) {
+    static const struct {
+        const char *name;
+        cpu_kernel_fn fn;
+        cpu_isa_t isa;
+    } kernels[] = {
+        {"scalar", cpu_kernel_scalar, ISA_NONE},
+        {"multi", cpu_kernel_multi, ISA_NONE},
+#ifdef CPU_KERNELS_X86
+        {"autovec", cpu_kernel_autovec, ISA_NONE},
+        {"sse", cpu_kernel_sse, ISA_SSE2},
+        {"avx2", cpu_kernel_avx2, ISA_AVX2},
+        {"avx512", cpu_kernel_avx512, ISA_AVX512},
+#endif
+    };
+    int n = sizeof(kernels) / sizeof(kernels[0]);
+    int pick = -1;
+
+    if (strcmp(name, "best") == 0) {
+        pick = 1; // multi when there is no SIMD kernel
+        for (int i = 0; i < n; i++) {
+            if (kernels[i].isa != ISA_NONE && cpu_isa_supported(kernels[i].isa)) pick = i;
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            if (strcmp(name, kernels[i].name) == 0) pick = i;
+        }
+        if (pick < 0) {
+            fprintf(stderr, "Unknown cpu kernel: %s\n", name);
+            return -1;
+        }
+        if (!cpu_isa_supported(kernels[pick].isa)) {
+            fprintf(stderr, "This CPU cannot run the %s kernel\n", name);
+            return -1;
+        }
+    }
+    cpu_kernel = kernels[pick].fn;
+    cpu_kernel_name = kernels[pick].name;
+    return 0;
+}
+
+void cpu_range(long begin, long end) {
+    cpu_sink = cpu_kernel(begin, end);
+}
+
+double cpu_flops(long long n) {
+    return (double)n * CPU_INNER_ITERS * CPU_FLOPS_PER_ELEM;
+}
+
+void report_gflops(const char *program, int count, const worker_stats_t *workers,
+                   const worker_stats_t *run, double iters_per_op) {
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        double flops = cpu_flops(workers[i].ops) * iters_per_op;
+        total += flops;
+        printf("GFLOPS,%s,%s,%d,%d,%d,%.3f\n", program, cpu_kernel_name, count, workers[i].id,
+               workers[i].cpu, workers[i].wall_s > 0 ? flops / workers[i].wall_s / 1e9 : 0.0);
+    }
+    printf("GFLOPS,%s,%s,%d,-1,-1,%.3f\n", program, cpu_kernel_name, count,
+           run->wall_s > 0 ? total / run->wall_s / 1e9 : 0.0);
+}
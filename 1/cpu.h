@@ -0,0 +1,32 @@
+// CPU kernels for the cpu job. Every kernel computes the same sum over outer
+// iterations [begin, end):
+//   sum over k, i of (i * 0.001) + (k * 0.1)
+// i.e. one multiply and two adds per element. They differ only in how much
+// independent work the core sees at once.
+#ifndef CPU_H
+#define CPU_H
+
+#include "stats.h"
+
+// Name of the selected kernel, for reports
+extern const char *cpu_kernel_name;
+
+// Select the cpu job's kernel by name: scalar, multi, autovec, sse, avx2,
+// avx512, or best (the widest explicit kernel this CPU runs). Returns -1 for
+// an unknown name or an ISA the CPU lacks.
+int select_cpu_kernel(const char *name);
+
+// Outer iterations [begin, end) of the cpu job
+void cpu_range(long begin, long end);
+
+// Floating-point operations in n outer iterations of the cpu job
+double cpu_flops(long long n);
+
+// Throughput of a cpu run: one line per worker and one aggregate line (id -1)
+//   GFLOPS,<program>,<kernel>,<N>,<id>,<cpu>,<gflops>
+// iters_per_op converts ops to outer iterations (1 in the default mode,
+// outer iterations per chunk in strong mode)
+void report_gflops(const char *program, int count, const worker_stats_t *workers,
+                   const worker_stats_t *run, double iters_per_op);
+
+#endif
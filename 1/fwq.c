@@ -0,0 +1,109 @@
+#include "fwq.h"
+#include <sched.h>
+#include <sys/mman.h>
+
+#define FWQ_SAMPLES 100000
+#define FWQ_WORK 4000           // LCG steps per quantum (a few microseconds)
+#define FWQ_TOP 5               // Largest interruptions listed per worker
+
+typedef struct {
+    uint64_t at_ns;     // Sample start, CLOCK_MONOTONIC since fwq_origin
+    uint32_t ns;
+    int32_t cpu;
+} fwq_sample_t;
+
+static fwq_sample_t *fwq_buf = NULL;
+static size_t fwq_size = 0;
+static struct timespec fwq_origin;     // Run start, shared by every worker's log
+static volatile uint64_t fwq_sink;
+
+int fwq_setup(int count) {
+    clock_gettime(CLOCK_MONOTONIC, &fwq_origin);
+    fwq_size = sizeof(fwq_sample_t) * FWQ_SAMPLES * count;
+    fwq_buf = mmap(NULL, fwq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (fwq_buf == MAP_FAILED) {
+        perror("mmap failed");
+        fwq_buf = NULL;
+        return -1;
+    }
+    memset(fwq_buf, 0, fwq_size);
+    return 0;
+}
+
+void fwq_release(void) {
+    if (!fwq_buf) return;
+    munmap(fwq_buf, fwq_size);
+    fwq_buf = NULL;
+}
+
+void fwq_run(worker_stats_t *s) {
+    fwq_sample_t *log = fwq_buf + (size_t)s->id * FWQ_SAMPLES;
+    uint64_t x = (uint64_t)s->id + 1;
+
+    s->work_t0 = now_sec();
+    for (long i = 0; i < FWQ_SAMPLES; i++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int k = 0; k < FWQ_WORK; k++) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            __asm__ volatile("" : "+r"(x));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        long ns = (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec);
+        log[i].at_ns = (uint64_t)(t0.tv_sec - fwq_origin.tv_sec) * 1000000000ULL +
+                       (t0.tv_nsec - fwq_origin.tv_nsec);
+        log[i].ns = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+        log[i].cpu = sched_getcpu();
+    }
+    s->work_t1 = now_sec();
+    s->ops = FWQ_SAMPLES;
+    fwq_sink = x;
+}
+
+void report_fwq(const char *program, int count, const worker_stats_t *workers) {
+    double *v = malloc(sizeof(double) * FWQ_SAMPLES);
+    if (!v) return;
+    double worst[6] = {0}; // p50, p99, p999, max, noise, min
+    long migrations = 0, nivcsw = 0;
+
+    for (int i = 0; i < count; i++) {
+        const fwq_sample_t *log = fwq_buf + (size_t)i * FWQ_SAMPLES;
+        double total = 0.0;
+        long moved = 0;
+        int top[FWQ_TOP];
+        for (int r = 0; r < FWQ_TOP; r++) top[r] = -1;
+
+        for (long k = 0; k < FWQ_SAMPLES; k++) {
+            v[k] = log[k].ns / 1e3;
+            total += v[k];
+            if (k > 0 && log[k].cpu != log[k - 1].cpu) moved++;
+            // Insertion into the (descending) top list
+            int r = FWQ_TOP;
+            while (r > 0 && (top[r - 1] < 0 || log[top[r - 1]].ns < log[k].ns)) r--;
+            if (r < FWQ_TOP) {
+                memmove(&top[r + 1], &top[r], sizeof(int) * (FWQ_TOP - r - 1));
+                top[r] = (int)k;
+            }
+        }
+        qsort(v, FWQ_SAMPLES, sizeof(double), cmp_double);
+        double min = v[0];
+        double noise = total > 0 ? 100.0 * (total - min * FWQ_SAMPLES) / total : 0.0;
+        double q[6] = {percentile(v, FWQ_SAMPLES, 0.50), percentile(v, FWQ_SAMPLES, 0.99),
+                       percentile(v, FWQ_SAMPLES, 0.999), v[FWQ_SAMPLES - 1], noise, min};
+        printf("FWQ,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%ld\n", program, count, i, min, q[0], q[1],
+               q[2], q[3], noise, moved, workers[i].nivcsw);
+        for (int m = 0; m < 6; m++) {
+            if (i == 0 || (m == 5 ? q[m] < worst[m] : q[m] > worst[m])) worst[m] = q[m];
+        }
+        migrations += moved;
+        nivcsw += workers[i].nivcsw;
+
+        for (int r = 0; r < FWQ_TOP && top[r] >= 0; r++) {
+            printf("FWQTOP,%s,%d,%d,%d,%.3f,%.3f,%d\n", program, count, i, r + 1, log[top[r]].at_ns / 1e6,
+                   log[top[r]].ns / 1e3, log[top[r]].cpu);
+        }
+    }
+    printf("FWQ,%s,%d,-1,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%ld\n", program, count, worst[5], worst[0],
+           worst[1], worst[2], worst[3], worst[4], migrations, nivcsw);
+    free(v);
+}
@@ -0,0 +1,25 @@
+// OS noise (FWQ, fixed work quantum): every worker runs the same tiny work
+// unit FWQ_SAMPLES times back to back and logs each duration (and the CPU it
+// ended on) into a MAP_SHARED buffer that was allocated and touched before
+// the workers started, so logging never faults. With nothing else on the
+// CPU every sample takes the minimum; anything above it is time stolen by
+// timer ticks, IRQs, kernel threads, other workers or migrations.
+#ifndef FWQ_H
+#define FWQ_H
+
+#include "stats.h"
+
+int fwq_setup(int count);
+void fwq_release(void);
+
+void fwq_run(worker_stats_t *s);
+
+// Per worker, then the worst worker (id -1):
+//   FWQ,<program>,<N>,<id>,<min_us>,<p50_us>,<p99_us>,<p999_us>,<max_us>,<noise_pct>,<migrations>,<nivcsw>
+// noise_pct is the share of time above the minimum quantum; migrations
+// counts CPU changes between samples. The largest interruptions follow:
+//   FWQTOP,<program>,<N>,<id>,<rank>,<at_ms>,<sample_us>,<cpu>
+// at_ms is when the sample started, since the run start (same for all workers).
+void report_fwq(const char *program, int count, const worker_stats_t *workers);
+
+#endif
@@ -0,0 +1,306 @@
+#include "ioeng.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#define IO_TOTAL_BYTES ((long)IO_RECORDS * IO_RECORD_SIZE)
+#define IO_SYNC_BYTES ((long)IO_SYNC_EVERY * IO_RECORD_SIZE)
+#define IO_DIRECT_ALIGN 4096
+#define IO_IOV_MAX 8        // Blocks gathered per pwritev() call
+#define IO_DEFAULT_DEPTH 8
+
+typedef enum { IOE_STDIO, IOE_PWRITE, IOE_PWRITEV, IOE_DIRECT, IOE_URING, IOE_MMAP } io_engine_t;
+typedef enum { SYNC_FSYNC, SYNC_FDATASYNC, SYNC_RANGE, SYNC_NONE } io_sync_t;
+
+static const char *io_engine_names[] = {"stdio", "pwrite", "pwritev", "direct", "uring", "mmap"};
+static const char *io_sync_names[] = {"fsync", "fdatasync", "sync_file_range", "none"};
+static io_engine_t io_engine = IOE_STDIO;
+static io_sync_t io_sync = SYNC_FSYNC;
+long io_block = IO_RECORD_SIZE;
+int io_depth = IO_DEFAULT_DEPTH;
+
+int select_io_engine(const char *name) {
+    int e = find_name(io_engine_names, IOE_MMAP + 1, name);
+    if (e < 0) {
+        fprintf(stderr, "Unknown io engine: %s\n", name);
+        return -1;
+    }
+    io_engine = (io_engine_t)e;
+    return 0;
+}
+
+int select_io_sync(const char *name) {
+    int p = find_name(io_sync_names, SYNC_NONE + 1, name);
+    if (p < 0) {
+        fprintf(stderr, "Unknown sync policy: %s\n", name);
+        return -1;
+    }
+    io_sync = (io_sync_t)p;
+    return 0;
+}
+
+int io_is_default(void) {
+    return io_engine == IOE_STDIO && io_sync == SYNC_FSYNC && io_block == IO_RECORD_SIZE;
+}
+
+int io_check_config(void) {
+    if (io_block < 1 || io_block > IO_TOTAL_BYTES) {
+        fprintf(stderr, "Block size must be between 1 and %ld bytes\n", IO_TOTAL_BYTES);
+        return -1;
+    }
+    // A remainder would go unwritten and MB/s, IOPS would cover fewer bytes
+    if (IO_TOTAL_BYTES % io_block != 0) {
+        fprintf(stderr, "Block size must divide the %ld-byte job\n", IO_TOTAL_BYTES);
+        return -1;
+    }
+    if (io_engine == IOE_DIRECT && io_block % IO_DIRECT_ALIGN != 0) {
+        fprintf(stderr, "O_DIRECT needs a block size that is a multiple of %d\n", IO_DIRECT_ALIGN);
+        return -1;
+    }
+    if (io_depth < 1 || io_depth > 4096) {
+        fprintf(stderr, "Queue depth must be between 1 and 4096\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Flush [off, off + len) under the sync policy. map is the mmap engine's
+// mapping (NULL otherwise); fsync/fdatasync become msync() there.
+static int io_sync_range(int fd, char *map, long off, long len) {
+    if (io_sync == SYNC_NONE) return 0;
+    if (io_sync == SYNC_RANGE) {
+        return sync_file_range(fd, off, len, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                             SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+    if (map) {
+        long start = off / MEM_PAGE * MEM_PAGE;
+        return msync(map + start, off + len - start, MS_SYNC);
+    }
+    return io_sync == SYNC_FDATASYNC ? fdatasync(fd) : fsync(fd);
+}
+
+// io_uring through raw syscalls (no liburing)
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    unsigned inflight;
+} uring_t;
+
+static int uring_open(uring_t *r, unsigned depth) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+    r->fd = (int)syscall(__NR_io_uring_setup, depth, &p);
+    if (r->fd < 0) return -1;
+
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_len > r->sq_len) r->sq_len = r->cq_len;
+        r->cq_len = r->sq_len;
+    }
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) return -1;
+    r->cq_ptr = (p.features & IORING_FEAT_SINGLE_MMAP) ? r->sq_ptr :
+        mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             r->fd, IORING_OFF_CQ_RING);
+    if (r->cq_ptr == MAP_FAILED) return -1;
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) return -1;
+
+    char *sq = r->sq_ptr, *cq = r->cq_ptr;
+    r->sq_head = (unsigned *)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_close(uring_t *r) {
+    if (r->sqes && r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_len);
+    if (r->cq_ptr && r->cq_ptr != MAP_FAILED && r->cq_ptr != r->sq_ptr) munmap(r->cq_ptr, r->cq_len);
+    if (r->sq_ptr && r->sq_ptr != MAP_FAILED) munmap(r->sq_ptr, r->sq_len);
+    if (r->fd >= 0) close(r->fd);
+}
+
+// Queue and submit one write
+static int uring_write(uring_t *r, int fd, const void *buf, unsigned len, long off) {
+    unsigned tail = *r->sq_tail;
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = len;
+    sqe->off = off;
+    r->sq_array[idx] = idx;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    if (syscall(__NR_io_uring_enter, r->fd, 1, 0, 0, NULL, 0) < 0) return -1;
+    r->inflight++;
+    return 0;
+}
+
+// Wait until at most keep writes are in flight; -1 if any write failed
+static int uring_reap(uring_t *r, unsigned keep) {
+    int failed = 0;
+    while (r->inflight > keep) {
+        unsigned head = *r->cq_head;
+        if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+            if (syscall(__NR_io_uring_enter, r->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+                return -1;
+            continue;
+        }
+        struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+        if (cqe->res < 0 || (unsigned long)cqe->res != (unsigned long)io_block) failed = 1;
+        __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+        r->inflight--;
+    }
+    return failed ? -1 : 0;
+}
+
+void io_engine_run(worker_stats_t *s, const char *filename, char fill) {
+    long nblocks = IO_TOTAL_BYTES / io_block;
+    long per_sync = IO_SYNC_BYTES / io_block > 0 ? IO_SYNC_BYTES / io_block : 1;
+    double *lat = malloc(sizeof(double) * (nblocks / per_sync + 2));
+    char *buf = aligned_alloc(IO_DIRECT_ALIGN, (io_block + IO_DIRECT_ALIGN - 1) / IO_DIRECT_ALIGN
+                                                   * IO_DIRECT_ALIGN);
+    if (!lat || !buf) {
+        free(lat);
+        free(buf);
+        return;
+    }
+    memset(buf, fill, io_block);
+
+    FILE *fp = NULL;
+    int fd = -1;
+    char *map = NULL;
+    uring_t ring;
+    ring.fd = -1;
+    ring.sq_ptr = ring.cq_ptr = NULL;
+    ring.sqes = NULL;
+    int failed = 0;
+
+    s->work_t0 = now_sec();
+    if (io_engine == IOE_STDIO) {
+        fp = fopen(filename, "w");
+        if (fp) fd = fileno(fp);
+    } else {
+        int flags = O_CREAT | O_TRUNC | (io_engine == IOE_MMAP ? O_RDWR : O_WRONLY);
+        if (io_engine == IOE_DIRECT) flags |= O_DIRECT;
+        fd = open(filename, flags, 0644);
+    }
+    if (fd < 0) {
+        perror("Cannot open io file");
+        failed = 1;
+    } else if (io_engine == IOE_MMAP) {
+        if (ftruncate(fd, nblocks * io_block) < 0 ||
+            (map = mmap(NULL, nblocks * io_block, PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+            perror("mmap of io file failed");
+            map = NULL;
+            failed = 1;
+        }
+    } else if (io_engine == IOE_URING && uring_open(&ring, io_depth) < 0) {
+        perror("io_uring setup failed");
+        failed = 1;
+    }
+
+    struct iovec iov[IO_IOV_MAX];
+    for (int i = 0; i < IO_IOV_MAX; i++) {
+        iov[i].iov_base = buf;
+        iov[i].iov_len = io_block;
+    }
+
+    long b = 0, synced = 0;
+    while (!failed && b < nblocks) {
+        // Write up to the next sync point; pwritev gathers IO_IOV_MAX blocks per call
+        long n = 1;
+        if (io_engine == IOE_PWRITEV) {
+            n = per_sync - b % per_sync;
+            if (n > IO_IOV_MAX) n = IO_IOV_MAX;
+            if (n > nblocks - b) n = nblocks - b;
+        }
+        long off = b * io_block;
+        if (io_engine == IOE_STDIO) failed = fwrite(buf, 1, io_block, fp) != (size_t)io_block;
+        else if (io_engine == IOE_PWRITEV) failed = pwritev(fd, iov, n, off) != n * io_block;
+        else if (io_engine == IOE_URING) {
+            failed = uring_reap(&ring, io_depth - 1) < 0 ||
+                     uring_write(&ring, fd, buf, io_block, off) < 0;
+        } else if (io_engine == IOE_MMAP) memcpy(map + off, buf, io_block);
+        else failed = pwrite(fd, buf, io_block, off) != io_block;
+        b += n;
+
+        if (!failed && (b % per_sync == 0 || b == nblocks)) {
+            // Everything written so far must have reached the file first
+            if (io_engine == IOE_URING) failed = uring_reap(&ring, 0) < 0;
+            if (fp) failed |= fflush(fp) != 0;
+            double t0 = now_sec();
+            if (!failed && io_sync_range(fd, map, synced * io_block, (b - synced) * io_block) < 0) {
+                perror("sync failed");
+                failed = 1;
+            }
+            if (io_sync != SYNC_NONE) lat[s->sync_count++] = (now_sec() - t0) * 1e6;
+            synced = b;
+        }
+    }
+    if (failed && fd >= 0) fprintf(stderr, "%s engine: write failed after %ld blocks\n",
+                                   io_engine_names[io_engine], b);
+
+    if (map) munmap(map, nblocks * io_block);
+    if (io_engine == IOE_URING) uring_close(&ring);
+    if (fp) fclose(fp);
+    else if (fd >= 0) close(fd);
+    s->work_t1 = now_sec();
+    s->ops = failed ? 0 : nblocks;
+
+    qsort(lat, s->sync_count, sizeof(double), cmp_double);
+    s->sync_p50_us = percentile(lat, s->sync_count, 0.50);
+    s->sync_p99_us = percentile(lat, s->sync_count, 0.99);
+    s->sync_max_us = s->sync_count ? lat[s->sync_count - 1] : 0.0;
+    remove(filename);
+    free(lat);
+    free(buf);
+}
+
+void report_io(const char *program, int count, const worker_stats_t *workers) {
+    int depth = io_engine == IOE_URING ? io_depth : 1;
+    double bytes = 0.0, ops = 0.0, first = 0.0, last = 0.0;
+    double p50 = 0.0, p99 = 0.0, max = 0.0;
+    long syncs = 0;
+    for (int i = 0; i < count; i++) {
+        const worker_stats_t *w = &workers[i];
+        double t = w->work_t1 - w->work_t0;
+        if (t <= 0 || w->ops == 0) continue;
+        printf("IOENG,%s,%s,%s,%ld,%d,%d,%d,%.3f,%.1f,%ld,%.1f,%.1f,%.1f\n", program,
+               io_engine_names[io_engine], io_sync_names[io_sync], io_block, depth, count, w->id,
+               w->ops * io_block / t / 1048576, w->ops / t, w->sync_count, w->sync_p50_us,
+               w->sync_p99_us, w->sync_max_us);
+        bytes += (double)w->ops * io_block;
+        ops += w->ops;
+        syncs += w->sync_count;
+        if (w->sync_p50_us > p50) p50 = w->sync_p50_us;
+        if (w->sync_p99_us > p99) p99 = w->sync_p99_us;
+        if (w->sync_max_us > max) max = w->sync_max_us;
+        if (first == 0.0 || w->work_t0 < first) first = w->work_t0;
+        if (w->work_t1 > last) last = w->work_t1;
+    }
+    double span = last - first;
+    printf("IOENG,%s,%s,%s,%ld,%d,%d,-1,%.3f,%.1f,%ld,%.1f,%.1f,%.1f\n", program,
+           io_engine_names[io_engine], io_sync_names[io_sync], io_block, depth, count,
+           span > 0 ? bytes / span / 1048576 : 0.0, span > 0 ? ops / span : 0.0, syncs,
+           p50, p99, max);
+}
@@ -0,0 +1,32 @@
+// I/O engines. The default io job is buffered stdio: 1KB fwrite()s with
+// fflush()+fsync() every IO_SYNC_EVERY records. An engine run writes the same
+// IO_RECORDS * IO_RECORD_SIZE bytes in -B sized blocks and syncs every
+// IO_SYNC_BYTES, so the durability interval does not depend on the block size.
+#ifndef IOENG_H
+#define IOENG_H
+
+#include "stats.h"
+
+extern long io_block;
+extern int io_depth;
+
+int select_io_engine(const char *name);
+int select_io_sync(const char *name);
+
+// Nonzero for the plain io job: stdio, fsync, IO_RECORD_SIZE blocks
+int io_is_default(void);
+
+// Reject block sizes / depths the engine cannot use
+int io_check_config(void);
+
+// Write one io job to filename with the selected engine and sync policy;
+// ops are blocks written in [work_t0, work_t1], sync latencies in s
+void io_engine_run(worker_stats_t *s, const char *filename, char fill);
+
+// Throughput and sync latency of an engine run, one line per worker and an
+// aggregate line (id -1: all bytes over the span from the first start to
+// the last end, latencies of the worst worker):
+//   IOENG,<program>,<engine>,<sync>,<block>,<depth>,<N>,<id>,<MB/s>,<IOPS>,<syncs>,<p50_us>,<p99_us>,<max_us>
+void report_io(const char *program, int count, const worker_stats_t *workers);
+
+#endif
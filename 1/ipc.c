@@ -0,0 +1,232 @@
+#include "ipc.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define IPC_TOTAL_BYTES (256L * 1024 * 1024)
+#define IPC_RING_BYTES (1L * 1024 * 1024)
+#define IPC_DEFAULT_RECORD 4096
+#define IPC_SPIN_LIMIT 1000
+
+typedef enum { IPC_PIPE, IPC_VMSPLICE, IPC_UNIX, IPC_SEQPACKET, IPC_RING, IPC_QUEUE } ipc_transport_t;
+
+static const char *ipc_transport_names[] = {"pipe", "vmsplice", "unix", "seqpacket", "ring", "queue"};
+static ipc_transport_t ipc_transport = IPC_PIPE;
+long ipc_record = IPC_DEFAULT_RECORD;
+
+typedef struct {
+    volatile long head __attribute__((aligned(CACHE_LINE)));    // Records produced
+    volatile long tail __attribute__((aligned(CACHE_LINE)));    // Records consumed
+    pthread_mutex_t lock __attribute__((aligned(CACHE_LINE)));
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    long slots;
+    char data[] __attribute__((aligned(CACHE_LINE)));
+} ipc_ring_t;
+
+typedef struct {
+    int fds[2];         // [0] consumer end, [1] producer end
+    ipc_ring_t *ring;
+} ipc_channel_t;
+
+static ipc_channel_t *ipc_channels = NULL;
+static int ipc_pairs = 0;
+
+int select_ipc_transport(const char *name) {
+    int t = find_name(ipc_transport_names, IPC_QUEUE + 1, name);
+    if (t < 0) {
+        fprintf(stderr, "Unknown ipc transport: %s\n", name);
+        return -1;
+    }
+    ipc_transport = (ipc_transport_t)t;
+    return 0;
+}
+
+static size_t ipc_ring_size(void) {
+    return sizeof(ipc_ring_t) + IPC_RING_BYTES;
+}
+
+int ipc_setup(int pairs) {
+    if (ipc_record < 1 || ipc_record > IPC_RING_BYTES / 2) {
+        fprintf(stderr, "Record size must be between 1 and %ld bytes\n", IPC_RING_BYTES / 2);
+        return -1;
+    }
+    ipc_pairs = pairs;
+    ipc_channels = calloc(pairs, sizeof(ipc_channel_t));
+    if (!ipc_channels) return -1;
+
+    for (int p = 0; p < pairs; p++) {
+        ipc_channel_t *ch = &ipc_channels[p];
+        int rc = 0;
+        ch->fds[0] = ch->fds[1] = -1;
+        if (ipc_transport == IPC_PIPE || ipc_transport == IPC_VMSPLICE) {
+            int fds[2];
+            rc = pipe(fds);
+            ch->fds[0] = fds[0];
+            ch->fds[1] = fds[1];
+        } else if (ipc_transport == IPC_UNIX || ipc_transport == IPC_SEQPACKET) {
+            rc = socketpair(AF_UNIX, ipc_transport == IPC_UNIX ? SOCK_STREAM : SOCK_SEQPACKET, 0, ch->fds);
+        } else {
+            ipc_ring_t *r = mmap(NULL, ipc_ring_size(), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (r == MAP_FAILED) {
+                rc = -1;
+            } else {
+                pthread_mutexattr_t ma;
+                pthread_condattr_t ca;
+                pthread_mutexattr_init(&ma);
+                pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+                pthread_condattr_init(&ca);
+                pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+                pthread_mutex_init(&r->lock, &ma);
+                pthread_cond_init(&r->not_empty, &ca);
+                pthread_cond_init(&r->not_full, &ca);
+                pthread_mutexattr_destroy(&ma);
+                pthread_condattr_destroy(&ca);
+                r->slots = IPC_RING_BYTES / ipc_record;
+                ch->ring = r;
+            }
+        }
+        if (rc < 0) {
+            perror("ipc channel setup failed");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void ipc_release(void) {
+    for (int p = 0; p < ipc_pairs; p++) {
+        ipc_channel_t *ch = &ipc_channels[p];
+        if (ch->fds[0] >= 0) close(ch->fds[0]);
+        if (ch->fds[1] >= 0) close(ch->fds[1]);
+        if (ch->ring) {
+            pthread_mutex_destroy(&ch->ring->lock);
+            pthread_cond_destroy(&ch->ring->not_empty);
+            pthread_cond_destroy(&ch->ring->not_full);
+            munmap(ch->ring, ipc_ring_size());
+        }
+    }
+    free(ipc_channels);
+    ipc_channels = NULL;
+    ipc_pairs = 0;
+}
+
+// Spin on a condition, then start yielding the CPU
+static void spin_wait(long *spins) {
+    if (++*spins > IPC_SPIN_LIMIT) sched_yield();
+    else __asm__ volatile("" ::: "memory");
+}
+
+static int ring_put(ipc_ring_t *r, const char *rec) {
+    long head = r->head, spins = 0;
+    if (ipc_transport == IPC_QUEUE) {
+        pthread_mutex_lock(&r->lock);
+        while (head - r->tail == r->slots) pthread_cond_wait(&r->not_full, &r->lock);
+        memcpy(r->data + (head % r->slots) * ipc_record, rec, ipc_record);
+        r->head = head + 1;
+        pthread_cond_signal(&r->not_empty);
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    while (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == r->slots) spin_wait(&spins);
+    memcpy(r->data + (head % r->slots) * ipc_record, rec, ipc_record);
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int ring_get(ipc_ring_t *r, char *rec) {
+    long tail = r->tail, spins = 0;
+    if (ipc_transport == IPC_QUEUE) {
+        pthread_mutex_lock(&r->lock);
+        while (r->head == tail) pthread_cond_wait(&r->not_empty, &r->lock);
+        memcpy(rec, r->data + (tail % r->slots) * ipc_record, ipc_record);
+        r->tail = tail + 1;
+        pthread_cond_signal(&r->not_full);
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    while (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) spin_wait(&spins);
+    memcpy(rec, r->data + (tail % r->slots) * ipc_record, ipc_record);
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Loop over partial transfers of one record; -1 on error or EOF
+static int ipc_send(int fd, char *rec) {
+    long done = 0;
+    while (done < ipc_record) {
+        ssize_t n;
+        if (ipc_transport == IPC_VMSPLICE) {
+            struct iovec iov = {rec + done, (size_t)(ipc_record - done)};
+            n = vmsplice(fd, &iov, 1, 0);
+        } else if (ipc_transport == IPC_SEQPACKET) {
+            n = send(fd, rec, ipc_record, 0);
+        } else {
+            n = write(fd, rec + done, ipc_record - done);
+        }
+        if (n <= 0) return -1;
+        done += n;
+    }
+    return 0;
+}
+
+static int ipc_recv(int fd, char *rec) {
+    long done = 0;
+    while (done < ipc_record) {
+        ssize_t n = read(fd, rec + done, ipc_record - done);
+        if (n <= 0) return -1;
+        done += n;
+    }
+    return 0;
+}
+
+void ipc_run(worker_stats_t *s) {
+    ipc_channel_t *ch = &ipc_channels[s->id / 2];
+    int producer = s->id % 2 == 0;
+    long records = IPC_TOTAL_BYTES / ipc_record;
+    char *rec = aligned_alloc(MEM_PAGE, (ipc_record + MEM_PAGE - 1) / MEM_PAGE * MEM_PAGE);
+    if (!rec) return;
+    memset(rec, 'A' + s->id / 2 % 26, ipc_record);
+
+    s->work_t0 = now_sec();
+    for (long i = 0; i < records; i++) {
+        int rc;
+        if (ch->ring) rc = producer ? ring_put(ch->ring, rec) : ring_get(ch->ring, rec);
+        else rc = producer ? ipc_send(ch->fds[1], rec) : ipc_recv(ch->fds[0], rec);
+        if (rc < 0) {
+            perror(producer ? "ipc send failed" : "ipc receive failed");
+            break;
+        }
+        s->ops++;
+    }
+    s->work_t1 = now_sec();
+    free(rec);
+}
+
+int report_ipc(const char *program, int count, const worker_stats_t *workers) {
+    long expected = IPC_TOTAL_BYTES / ipc_record;
+    double records = 0.0, first = 0.0, last = 0.0;
+    int status = 0;
+    for (int p = 0; p < count / 2; p++) {
+        const worker_stats_t *prod = &workers[2 * p], *cons = &workers[2 * p + 1];
+        double t0 = prod->work_t0 < cons->work_t0 ? prod->work_t0 : cons->work_t0;
+        double t = cons->work_t1 - t0;
+        if (cons->ops != expected) status = -1;
+        if (t <= 0) continue;
+        printf("IPC,%s,%s,%ld,%d,%d,%.0f,%.3f\n", program, ipc_transport_names[ipc_transport],
+               ipc_record, count / 2, p, cons->ops / t, cons->ops * ipc_record / t / 1e9);
+        records += cons->ops;
+        if (first == 0.0 || t0 < first) first = t0;
+        if (cons->work_t1 > last) last = cons->work_t1;
+    }
+    double span = last - first;
+    printf("IPC,%s,%s,%ld,%d,-1,%.0f,%.3f\n", program, ipc_transport_names[ipc_transport],
+           ipc_record, count / 2, span > 0 ? records / span : 0.0,
+           span > 0 ? records * ipc_record / span / 1e9 : 0.0);
+    if (status < 0) fprintf(stderr, "ipc %s: a consumer missed records\n", ipc_transport_names[ipc_transport]);
+    return status;
+}
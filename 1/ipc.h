@@ -0,0 +1,33 @@
+// The ipc job: N producer/consumer pairs (2N workers; even ids produce, odd
+// ids consume) each stream IPC_TOTAL_BYTES in fixed-size records. Channels
+// are created before the workers start and work the same between processes
+// and between threads:
+//   pipe      - write()/read() on a pipe
+//   vmsplice  - vmsplice() the producer's buffer into the pipe, read() it out
+//   unix      - AF_UNIX SOCK_STREAM socketpair
+//   seqpacket - AF_UNIX SOCK_SEQPACKET socketpair, one record per message
+//   ring      - lock-free single-producer/single-consumer ring in MAP_SHARED
+//               memory; an empty/full side spins, then yields
+//   queue     - the same ring guarded by a process-shared mutex and condvars
+#ifndef IPC_H
+#define IPC_H
+
+#include "stats.h"
+
+extern long ipc_record;
+
+int select_ipc_transport(const char *name);
+
+int ipc_setup(int pairs);
+void ipc_release(void);
+
+// One side of a pair; ops are records moved in [work_t0, work_t1]
+void ipc_run(worker_stats_t *s);
+
+// Per-pair and aggregate throughput; a pair's time runs from the earlier
+// of its two starts to the consumer's end:
+//   IPC,<program>,<transport>,<record>,<pairs>,<pair>,<records/s>,<GB/s>
+// Returns -1 if a consumer received fewer records than expected.
+int report_ipc(const char *program, int count, const worker_stats_t *workers);
+
+#endif
@@ -0,0 +1,62 @@
+#include "job.h"
+#include "cpu.h"
+
+void mem_range(volatile char *arr, long begin, long end) {
+    for (int k = 0; k < MEM_PASSES; k++) {
+        for (long p = begin; p < end; p++) arr[p * MEM_PAGE] = (char)(k % 128);
+    }
+}
+
+// Records [begin, end) of the io job; syncs on the same record indices as a
+// single worker writing the whole job would
+static void io_range(FILE *fp, const char *buffer, long begin, long end) {
+    for (long i = begin; i < end; i++) {
+        fwrite(buffer, 1, IO_RECORD_SIZE, fp);
+        if (i % IO_SYNC_EVERY == 0) {
+            fflush(fp);
+            fsync(fileno(fp));
+        }
+    }
+}
+
+// Work units in one whole job
+static long job_units(job_kind_t kind) {
+    if (kind == JOB_CPU) return CPU_OUTER_ITERS;
+    if (kind == JOB_MEM) return MEM_SIZE / MEM_PAGE;
+    return IO_RECORDS;
+}
+
+int job_ctx_open(job_ctx_t *ctx, job_kind_t kind, long chunks, volatile char *mem,
+                 const char *filename, char fill) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->kind = kind;
+    ctx->chunks = chunks;
+    ctx->mem = mem;
+    if (kind == JOB_IO) {
+        snprintf(ctx->filename, sizeof(ctx->filename), "%s", filename);
+        ctx->fp = fopen(ctx->filename, "w");
+        if (!ctx->fp) return -1;
+        memset(ctx->buffer, fill, IO_RECORD_SIZE);
+    }
+    return 0;
+}
+
+void job_ctx_close(job_ctx_t *ctx) {
+    if (ctx->fp) {
+        fflush(ctx->fp);
+        fsync(fileno(ctx->fp));
+        fclose(ctx->fp);
+        remove(ctx->filename);
+        ctx->fp = NULL;
+    }
+}
+
+void run_chunk(job_ctx_t *ctx, long c) {
+    long units = job_units(ctx->kind);
+    long begin = units * c / ctx->chunks;
+    long end = units * (c + 1) / ctx->chunks;
+
+    if (ctx->kind == JOB_CPU) cpu_range(begin, end);
+    else if (ctx->kind == JOB_MEM) mem_range(ctx->mem, begin, end);
+    else io_range(ctx->fp, ctx->buffer, begin, end);
+}
@@ -0,0 +1,30 @@
+// Chunked jobs for strong scaling: one default job split into equal slices
+// that the workers claim and run
+#ifndef JOB_H
+#define JOB_H
+
+#include "common.h"
+
+#define DEFAULT_CHUNKS 256
+
+// Per-worker state for running chunks of a job
+typedef struct {
+    job_kind_t kind;
+    long chunks;
+    volatile char *mem;     // Shared buffer (JOB_MEM)
+    FILE *fp;               // Worker's own output file (JOB_IO)
+    char filename[64];
+    char buffer[IO_RECORD_SIZE];
+} job_ctx_t;
+
+// Pages [begin, end) of the mem job, touched once per pass
+void mem_range(volatile char *arr, long begin, long end);
+
+int job_ctx_open(job_ctx_t *ctx, job_kind_t kind, long chunks, volatile char *mem,
+                 const char *filename, char fill);
+void job_ctx_close(job_ctx_t *ctx);
+
+// Run chunk c of ctx->chunks equal slices of the job
+void run_chunk(job_ctx_t *ctx, long c);
+
+#endif
@@ -0,0 +1,277 @@
+#include "memkern.h"
+#include "job.h"
+#include "pages.h"
+
+#ifndef STREAM_ELEMS
+#define STREAM_ELEMS (4L * 1024 * 1024) // Doubles per array: 3 x 32MB per worker
+#endif
+#define STREAM_REPS 20
+#ifndef CHASE_SIZE
+#define CHASE_SIZE (64L * 1024 * 1024)
+#endif
+#define CHASE_STEPS (16L * 1024 * 1024)
+#define SWEEP_MIN (4L * 1024)
+#ifndef SWEEP_MAX
+#define SWEEP_MAX (128L * 1024 * 1024)
+#endif
+#define SWEEP_STEPS (2L * 1024 * 1024)        // Chase steps per working set
+#define SWEEP_READ_BYTES (256L * 1024 * 1024) // Bytes read per working set
+
+static const char *mem_kernel_names[] = {"touch", "copy", "scale", "add", "triad", "chase", "sweep",
+                                         "cowread", "cowwrite"};
+mem_kernel_t mem_kernel = MEM_TOUCH;
+
+int select_mem_kernel(const char *name) {
+    for (int k = MEM_TOUCH; k <= MEM_COWWRITE; k++) {
+        if (strcmp(name, mem_kernel_names[k]) == 0) {
+            mem_kernel = (mem_kernel_t)k;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Unknown mem kernel: %s\n", name);
+    return -1;
+}
+
+int mem_kernel_is_cow(void) {
+    return mem_kernel == MEM_COWREAD || mem_kernel == MEM_COWWRITE;
+}
+
+// Bytes moved per op: STREAM counts the arrays read and written per element
+static double mem_bytes_per_op(void) {
+    if (mem_kernel == MEM_COPY || mem_kernel == MEM_SCALE) return 2 * sizeof(double);
+    if (mem_kernel == MEM_ADD || mem_kernel == MEM_TRIAD) return 3 * sizeof(double);
+    if (mem_kernel == MEM_CHASE) return sizeof(size_t);
+    return 1;
+}
+
+static volatile double mem_sink;
+
+// Keeps the compiler from merging or dropping repeated passes
+#define MEM_BARRIER() __asm__ volatile("" ::: "memory")
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// One random cycle through every cache line of buf (Sattolo's algorithm), so
+// each load depends on the previous one and the prefetcher cannot follow.
+// Returns -1 (chain not built) if the shuffle buffer cannot be allocated.
+static int chase_build(size_t *buf, size_t bytes, uint64_t seed) {
+    size_t per_line = CACHE_LINE / sizeof(size_t);
+    size_t lines = bytes / CACHE_LINE;
+    size_t *order = malloc(lines * sizeof(size_t));
+    if (!order) {
+        perror("chase chain allocation failed");
+        return -1;
+    }
+    for (size_t i = 0; i < lines; i++) order[i] = i;
+    uint64_t rng = seed | 1;
+    for (size_t i = lines - 1; i > 0; i--) {
+        size_t j = xorshift64(&rng) % i;
+        size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (size_t i = 0; i < lines; i++) {
+        buf[order[i] * per_line] = order[(i + 1) % lines] * per_line;
+    }
+    free(order);
+    return 0;
+}
+
+// Follow the chain for steps loads; returns ns per load
+static double chase_run(const size_t *buf, long steps) {
+    size_t p = 0;
+    double t0 = now_sec();
+    for (long i = 0; i < steps; i++) p = buf[p];
+    double t = now_sec() - t0;
+    mem_sink = p;
+    return t * 1e9 / steps;
+}
+
+// Read bytes of buf with the given stride, repeated until total bytes have
+// been touched; returns ns per access
+static double stride_run(const char *buf, size_t bytes, size_t stride, long total) {
+    long accesses = 0;
+    unsigned long sum = 0;
+    double t0 = now_sec();
+    while (accesses * (long)stride < total) {
+        for (size_t off = 0; off < bytes; off += stride) sum += *(const unsigned long *)(buf + off);
+        accesses += bytes / stride;
+        MEM_BARRIER();
+    }
+    double t = now_sec() - t0;
+    mem_sink = sum;
+    return t * 1e9 / accesses;
+}
+
+// Working-set and stride sweep; prints one line per measurement:
+//   MEMSWEEP,<program>,<N>,<id>,<test>,<bytes>,<stride>,<ns/access>,<GB/s>
+// test is chase (dependent random loads, latency), read (sequential 8-byte
+// loads, bandwidth) or stride (fixed SWEEP_MAX buffer, growing stride)
+static void mem_sweep(worker_stats_t *s, const char *program, int count) {
+    char *buf = aligned_alloc(4096, SWEEP_MAX);
+    if (!buf) return;
+    memset(buf, 0, SWEEP_MAX);
+    s->work_t0 = now_sec();
+
+    for (long ws = SWEEP_MIN; ws <= SWEEP_MAX; ws *= 2) {
+        // No chain means no chase row: following a zeroed buffer would time L1 hits
+        if (chase_build((size_t *)buf, ws, 0x9e3779b97f4a7c15ULL ^ (uint64_t)(s->id + 1) ^ ws) == 0) {
+            double ns = chase_run((const size_t *)buf, SWEEP_STEPS);
+            printf("MEMSWEEP,%s,%d,%d,chase,%ld,%d,%.3f,%.3f\n", program, count, s->id, ws,
+                   CACHE_LINE, ns, CACHE_LINE / ns);
+            s->ops++;
+        }
+
+        double ns = stride_run(buf, ws, sizeof(unsigned long), SWEEP_READ_BYTES);
+        printf("MEMSWEEP,%s,%d,%d,read,%ld,%zu,%.3f,%.3f\n", program, count, s->id, ws,
+               sizeof(unsigned long), ns, sizeof(unsigned long) / ns);
+        s->ops++;
+    }
+    for (size_t stride = sizeof(unsigned long); stride <= 4096; stride *= 2) {
+        // Same number of accesses at every stride
+        long total = (long)stride * (SWEEP_READ_BYTES / CACHE_LINE);
+        double ns = stride_run(buf, SWEEP_MAX, stride, total);
+        printf("MEMSWEEP,%s,%d,%d,stride,%ld,%zu,%.3f,%.3f\n", program, count, s->id,
+               SWEEP_MAX, stride, ns, sizeof(unsigned long) / ns);
+        s->ops++;
+    }
+    s->work_t1 = now_sec();
+    free(buf);
+}
+
+void mem_kernel_run(worker_stats_t *s, const char *program, int count) {
+    if (mem_kernel == MEM_TOUCH) {
+        volatile char *arr = page_map(MEM_SIZE);
+        if (!arr) return;
+        s->work_t0 = now_sec();
+        mem_range(arr, 0, MEM_SIZE / MEM_PAGE);
+        s->work_t1 = now_sec();
+        page_usage(s);
+        page_unmap((void *)arr, MEM_SIZE);
+        s->ops = MEM_SIZE / MEM_PAGE;
+        return;
+    }
+
+    if (mem_kernel_is_cow()) {
+        unsigned long sum = 0;
+        s->work_t0 = now_sec();
+        for (size_t off = 0; off < cow_size; off += MEM_PAGE) {
+            if (mem_kernel == MEM_COWWRITE) cow_buf[off] = (char)s->id;
+            else sum += cow_buf[off];
+        }
+        s->work_t1 = now_sec();
+        mem_sink = sum;
+        page_usage(s);
+        s->ops = cow_size / MEM_PAGE;
+        return;
+    }
+
+    if (mem_kernel == MEM_SWEEP) {
+        mem_sweep(s, program, count);
+        return;
+    }
+
+    if (mem_kernel == MEM_CHASE) {
+        size_t *buf = aligned_alloc(4096, CHASE_SIZE);
+        if (!buf) return;
+        // ops stays 0, so report_membw() leaves this worker out
+        if (chase_build(buf, CHASE_SIZE, 0x9e3779b97f4a7c15ULL ^ (uint64_t)(s->id + 1)) < 0) {
+            free(buf);
+            return;
+        }
+        s->work_t0 = now_sec();
+        chase_run(buf, CHASE_STEPS);
+        s->work_t1 = now_sec();
+        s->ops = CHASE_STEPS;
+        free(buf);
+        return;
+    }
+
+    size_t bytes = STREAM_ELEMS * sizeof(double);
+    double *a = aligned_alloc(4096, bytes), *b = aligned_alloc(4096, bytes);
+    double *c = aligned_alloc(4096, bytes);
+    if (!a || !b || !c) {
+        free(a);
+        free(b);
+        free(c);
+        return;
+    }
+    // First touch by the worker itself (NUMA-local pages)
+    for (long j = 0; j < STREAM_ELEMS; j++) {
+        a[j] = 1.0;
+        b[j] = 2.0;
+        c[j] = 0.0;
+    }
+
+    const double q = 3.0;
+    s->work_t0 = now_sec();
+    for (int r = 0; r < STREAM_REPS; r++) {
+        if (mem_kernel == MEM_COPY) {
+            for (long j = 0; j < STREAM_ELEMS; j++) c[j] = a[j];
+        } else if (mem_kernel == MEM_SCALE) {
+            for (long j = 0; j < STREAM_ELEMS; j++) b[j] = q * c[j];
+        } else if (mem_kernel == MEM_ADD) {
+            for (long j = 0; j < STREAM_ELEMS; j++) c[j] = a[j] + b[j];
+        } else {
+            for (long j = 0; j < STREAM_ELEMS; j++) a[j] = b[j] + q * c[j];
+        }
+        MEM_BARRIER();
+    }
+    s->work_t1 = now_sec();
+    s->ops = (long long)STREAM_ELEMS * STREAM_REPS;
+    mem_sink = a[STREAM_ELEMS / 2] + b[STREAM_ELEMS / 3] + c[STREAM_ELEMS - 1];
+    free(a);
+    free(b);
+    free(c);
+}
+
+int report_membw(const char *program, int count, const worker_stats_t *workers) {
+    double bpo = mem_bytes_per_op(), bytes = 0.0, ops = 0.0;
+    double first = 0.0, last = 0.0;
+    int missing = 0;
+    for (int i = 0; i < count; i++) {
+        const worker_stats_t *w = &workers[i];
+        double t = w->work_t1 - w->work_t0;
+        if (t <= 0 || w->ops == 0) {
+            missing++;
+            continue;
+        }
+        printf("MEMBW,%s,%s,%d,%d,%d,%.3f,%.3f\n", program, mem_kernel_names[mem_kernel], count,
+               w->id, w->cpu, w->ops * bpo / t / 1e9, t * 1e9 / w->ops);
+        bytes += w->ops * bpo;
+        ops += w->ops;
+        if (first == 0.0 || w->work_t0 < first) first = w->work_t0;
+        if (w->work_t1 > last) last = w->work_t1;
+    }
+    double span = last - first;
+    // ns/access of the aggregate: time per access seen by one worker
+    printf("MEMBW,%s,%s,%d,-1,-1,%.3f,%.3f\n", program, mem_kernel_names[mem_kernel], count,
+           span > 0 ? bytes / span / 1e9 : 0.0, ops > 0 ? span * 1e9 * count / ops : 0.0);
+    if (missing > 0) {
+        fprintf(stderr, "%s: %d of %d workers measured nothing\n", mem_kernel_names[mem_kernel],
+                missing, count);
+        return -1;
+    }
+    return 0;
+}
+
+void report_pages(const char *program, int count, const worker_stats_t *workers) {
+    for (int i = 0; i < count; i++) {
+        const worker_stats_t *w = &workers[i];
+        if (w->ops == 0) continue; // Buffer could not be mapped
+        printf("MEMPAGE,%s,%s,%s,%d,%d,%ld,%ld,%ld,%ld,%.6f\n", program,
+               mem_kernel_names[mem_kernel], page_label(), count, w->id, w->minflt, w->majflt,
+               w->pte_kb, w->thp_kb, w->work_t1 - w->work_t0);
+    }
+    if (mem_kernel_is_cow()) {
+        printf("MEMSETUP,%s,%s,%d,%zu,%ld,%ld,%ld,%.6f,%.6f\n", program, page_label(), count,
+               cow_size >> 20, cow_setup.minflt, cow_setup.pte_kb, cow_setup.thp_kb,
+               cow_setup.touch_s, cow_setup.spawn_s);
+    }
+}
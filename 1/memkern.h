@@ -0,0 +1,38 @@
+// Memory kernels. The default mem job (touch) writes one byte per page, so it
+// mostly measures page faults and the TLB. The other kernels measure the
+// memory system itself, each in private per-worker buffers touched before
+// timing starts.
+#ifndef MEMKERN_H
+#define MEMKERN_H
+
+#include "stats.h"
+
+typedef enum {
+    MEM_TOUCH, MEM_COPY, MEM_SCALE, MEM_ADD, MEM_TRIAD, MEM_CHASE, MEM_SWEEP,
+    MEM_COWREAD, MEM_COWWRITE
+} mem_kernel_t;
+
+extern mem_kernel_t mem_kernel;
+
+// Returns -1 for an unknown name
+int select_mem_kernel(const char *name);
+
+int mem_kernel_is_cow(void);
+
+// Run the selected memory kernel in this worker. For STREAM and chase,
+// ops are elements (loads for chase) processed in [work_t0, work_t1].
+void mem_kernel_run(worker_stats_t *s, const char *program, int count);
+
+// Throughput of a STREAM or chase run: one line per worker and one aggregate
+// line (id -1, all bytes over the span from the first start to the last end)
+//   MEMBW,<program>,<kernel>,<N>,<id>,<cpu>,<GB/s>,<ns/access>
+// Returns -1 if a worker could not set up its buffers and measured nothing.
+int report_membw(const char *program, int count, const worker_stats_t *workers);
+
+// Page-level cost of a touch or cow* run, one line per worker:
+//   MEMPAGE,<program>,<kernel>,<pages>,<N>,<id>,<minflt>,<majflt>,<pte_kb>,<thp_kb>,<work_s>
+// and for cow* what the main task paid before and while creating workers:
+//   MEMSETUP,<program>,<pages>,<N>,<buf_mb>,<minflt>,<pte_kb>,<thp_kb>,<touch_s>,<spawn_s>
+void report_pages(const char *program, int count, const worker_stats_t *workers);
+
+#endif
@@ -0,0 +1,104 @@
+#include "pages.h"
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#define HUGE_PAGE (2L * 1024 * 1024)
+
+typedef enum { PAGES_DEFAULT, PAGES_4K, PAGES_THP, PAGES_HUGETLB } page_mode_t;
+
+static const char *page_mode_names[] = {"default", "4k", "thp", "hugetlb"};
+static page_mode_t page_mode = PAGES_DEFAULT;
+static int page_populate = 0;
+
+int select_page_mode(const char *spec) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s", spec);
+    char *plus = strchr(name, '+');
+    if (plus) {
+        if (strcmp(plus + 1, "populate") != 0) {
+            fprintf(stderr, "Unknown page option: %s\n", plus + 1);
+            return -1;
+        }
+        page_populate = 1;
+        *plus = '\0';
+    }
+    for (int m = PAGES_DEFAULT; m <= PAGES_HUGETLB; m++) {
+        if (strcmp(name, page_mode_names[m]) == 0) {
+            page_mode = (page_mode_t)m;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Unknown page mode: %s\n", name);
+    return -1;
+}
+
+const char *page_label(void) {
+    static char label[32];
+    snprintf(label, sizeof(label), "%s%s", page_mode_names[page_mode],
+             page_populate ? "+populate" : "");
+    return label;
+}
+
+static size_t page_round(size_t size) {
+    return page_mode == PAGES_HUGETLB ? (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE : size;
+}
+
+void *page_map(size_t size) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (page_mode == PAGES_HUGETLB) flags |= MAP_HUGETLB;
+    // MAP_POPULATE would fault before madvise() could pick the page size
+    int populate_now = page_populate && (page_mode == PAGES_DEFAULT || page_mode == PAGES_HUGETLB);
+    if (populate_now) flags |= MAP_POPULATE;
+
+    void *p = mmap(NULL, page_round(size), PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) {
+        if (page_mode == PAGES_HUGETLB) perror("MAP_HUGETLB failed (reserve pages in vm.nr_hugepages)");
+        else perror("mmap failed");
+        return NULL;
+    }
+    if (page_mode == PAGES_4K) madvise(p, size, MADV_NOHUGEPAGE);
+    if (page_mode == PAGES_THP) madvise(p, size, MADV_HUGEPAGE);
+    if (page_populate && !populate_now) {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(p, size, MADV_POPULATE_WRITE) == 0) return p;
+#endif
+        for (size_t off = 0; off < size; off += MEM_PAGE) ((volatile char *)p)[off] = 0;
+    }
+    return p;
+}
+
+void page_unmap(void *p, size_t size) {
+    if (p) munmap(p, page_round(size));
+}
+
+void page_usage(worker_stats_t *s) {
+    s->pte_kb = read_proc_kb("/proc/self/status", "VmPTE");
+    s->thp_kb = read_proc_kb("/proc/self/smaps_rollup", "AnonHugePages");
+}
+
+#define COW_DEFAULT_SIZE MEM_SIZE
+
+volatile char *cow_buf = NULL;
+size_t cow_size = COW_DEFAULT_SIZE;
+
+cow_setup_t cow_setup;
+
+int cow_prepare(void) {
+    struct rusage ru0, ru;
+    getrusage(RUSAGE_SELF, &ru0);
+    double t0 = now_sec();
+    cow_buf = page_map(cow_size);
+    if (!cow_buf) return -1;
+    for (size_t off = 0; off < cow_size; off += MEM_PAGE) cow_buf[off] = 1;
+    cow_setup.touch_s = now_sec() - t0;
+    getrusage(RUSAGE_SELF, &ru);
+    cow_setup.minflt = ru.ru_minflt - ru0.ru_minflt;
+    cow_setup.pte_kb = read_proc_kb("/proc/self/status", "VmPTE");
+    cow_setup.thp_kb = read_proc_kb("/proc/self/smaps_rollup", "AnonHugePages");
+    return 0;
+}
+
+void cow_release(void) {
+    page_unmap((void *)cow_buf, cow_size);
+    cow_buf = NULL;
+}
@@ -0,0 +1,45 @@
+// Page policy: how the touch and cow* buffers are mapped. The system
+// default, 4K pages (MADV_NOHUGEPAGE), transparent huge pages (MADV_HUGEPAGE)
+// or hugetlbfs pages (MAP_HUGETLB, needs vm.nr_hugepages), optionally
+// prefaulted with MAP_POPULATE.
+//
+// Copy-on-write study: for cowread/cowwrite the main task maps and touches
+// one buffer before creating the workers. Forked workers then share it
+// copy-on-write, threads share it outright; every worker reads or writes one
+// byte per 4K page.
+#ifndef PAGES_H
+#define PAGES_H
+
+#include "stats.h"
+
+// "thp", "4k+populate", ...; returns -1 for an unknown mode
+int select_page_mode(const char *spec);
+
+// Label for reports, e.g. "thp+populate"
+const char *page_label(void);
+
+// Private anonymous buffer under the current page policy (NULL on failure)
+void *page_map(size_t size);
+void page_unmap(void *p, size_t size);
+
+// Page-table and huge-page footprint of this process, into s
+void page_usage(worker_stats_t *s);
+
+extern volatile char *cow_buf;
+extern size_t cow_size;
+
+// What the main task paid before the workers started
+typedef struct {
+    double touch_s;     // Map and pre-touch the buffer
+    double spawn_s;     // Create all workers (fork() or pthread_create())
+    long minflt;
+    long pte_kb;
+    long thp_kb;
+} cow_setup_t;
+
+extern cow_setup_t cow_setup;
+
+int cow_prepare(void);
+void cow_release(void);
+
+#endif
@@ -0,0 +1,278 @@
+#include "pingpong.h"
+#include "affinity.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <linux/futex.h>
+
+#define PING_ROUNDS 20000
+#define PING_WARMUP 1000
+#define PING_SPIN_US 50      // Spin budget before blocking in +spin mode
+#define PING_SUB_BITS 2     // Histogram: 4 linear sub-buckets per power of two
+#define PING_BUCKETS (64 << PING_SUB_BITS)
+
+typedef enum { WAKE_FUTEX, WAKE_EVENTFD, WAKE_PIPE, WAKE_CONDVAR } wake_mech_t;
+
+static const char *wake_mech_names[] = {"futex", "eventfd", "pipe", "condvar"};
+static wake_mech_t wake_mech = WAKE_FUTEX;
+static int wake_spin = 0;
+
+// One direction of a pair
+typedef struct {
+    int word __attribute__((aligned(CACHE_LINE))); // futex: 0 idle, 1 posted, 2 waiter asleep
+    int flag;                                       // condvar / spin flag
+    int fds[2];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} ping_door_t;
+
+typedef struct {
+    ping_door_t ping;
+    ping_door_t pong;
+    long hist[PING_BUCKETS]; // Round trips in ns, filled by the even worker
+} ping_pair_t;
+
+static ping_pair_t *ping_pairs = NULL;
+static int ping_npairs = 0;
+
+int select_wake_mech(const char *spec) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s", spec);
+    char *plus = strchr(name, '+');
+    if (plus) {
+        if (strcmp(plus + 1, "spin") != 0) {
+            fprintf(stderr, "Unknown wake option: %s\n", plus + 1);
+            return -1;
+        }
+        wake_spin = 1;
+        *plus = '\0';
+    }
+    int m = find_name(wake_mech_names, WAKE_CONDVAR + 1, name);
+    if (m < 0) {
+        fprintf(stderr, "Unknown wake mechanism: %s\n", name);
+        return -1;
+    }
+    wake_mech = (wake_mech_t)m;
+    return 0;
+}
+
+static int door_init(ping_door_t *d) {
+    d->fds[0] = d->fds[1] = -1;
+    if (wake_mech == WAKE_EVENTFD) {
+        d->fds[0] = d->fds[1] = eventfd(0, wake_spin ? EFD_NONBLOCK : 0);
+        if (d->fds[0] < 0) return -1;
+    } else if (wake_mech == WAKE_PIPE) {
+        if (pipe2(d->fds, wake_spin ? O_NONBLOCK : 0) < 0) return -1;
+    } else if (wake_mech == WAKE_CONDVAR) {
+        pthread_mutexattr_t ma;
+        pthread_condattr_t ca;
+        pthread_mutexattr_init(&ma);
+        pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_init(&ca);
+        pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+        pthread_mutex_init(&d->lock, &ma);
+        pthread_cond_init(&d->cond, &ca);
+        pthread_mutexattr_destroy(&ma);
+        pthread_condattr_destroy(&ca);
+    }
+    return 0;
+}
+
+static void door_destroy(ping_door_t *d) {
+    if (wake_mech == WAKE_CONDVAR) {
+        pthread_mutex_destroy(&d->lock);
+        pthread_cond_destroy(&d->cond);
+    }
+    if (d->fds[0] >= 0) close(d->fds[0]);
+    if (d->fds[1] >= 0 && d->fds[1] != d->fds[0]) close(d->fds[1]);
+}
+
+int ping_setup(int pairs) {
+    ping_npairs = pairs;
+    ping_pairs = mmap(NULL, sizeof(ping_pair_t) * pairs, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ping_pairs == MAP_FAILED) {
+        perror("mmap failed");
+        ping_pairs = NULL;
+        return -1;
+    }
+    for (int p = 0; p < pairs; p++) {
+        if (door_init(&ping_pairs[p].ping) < 0 || door_init(&ping_pairs[p].pong) < 0) {
+            perror("pingpong setup failed");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void ping_release(void) {
+    if (!ping_pairs) return;
+    for (int p = 0; p < ping_npairs; p++) {
+        door_destroy(&ping_pairs[p].ping);
+        door_destroy(&ping_pairs[p].pong);
+    }
+    munmap(ping_pairs, sizeof(ping_pair_t) * ping_npairs);
+    ping_pairs = NULL;
+}
+
+static void door_post(ping_door_t *d) {
+    uint64_t one = 1;
+    if (wake_mech == WAKE_FUTEX) {
+        if (__atomic_exchange_n(&d->word, 1, __ATOMIC_RELEASE) == 2) futex_op(&d->word, FUTEX_WAKE, 1);
+    } else if (wake_mech == WAKE_EVENTFD) {
+        if (write(d->fds[1], &one, sizeof(one)) != sizeof(one)) perror("eventfd write failed");
+    } else if (wake_mech == WAKE_PIPE) {
+        if (write(d->fds[1], "x", 1) != 1) perror("pipe write failed");
+    } else {
+        pthread_mutex_lock(&d->lock);
+        __atomic_store_n(&d->flag, 1, __ATOMIC_RELEASE);
+        pthread_cond_signal(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+    }
+}
+
+// Poll a file descriptor (non-blocking in spin mode) until one post is consumed
+static void door_read(ping_door_t *d) {
+    uint64_t v;
+    size_t len = wake_mech == WAKE_EVENTFD ? sizeof(v) : 1;
+    double deadline = now_sec() + PING_SPIN_US / 1e6;
+    while (1) {
+        if (read(d->fds[0], &v, len) == (ssize_t)len) return;
+        if (!wake_spin) {
+            perror("pingpong read failed");
+            return;
+        }
+        if (now_sec() > deadline) {
+            struct pollfd pfd = {d->fds[0], POLLIN, 0};
+            poll(&pfd, 1, -1);
+        }
+    }
+}
+
+static void door_wait(ping_door_t *d) {
+    if (wake_mech == WAKE_EVENTFD || wake_mech == WAKE_PIPE) {
+        door_read(d);
+        return;
+    }
+    int *word = wake_mech == WAKE_FUTEX ? &d->word : &d->flag;
+    if (wake_spin) {
+        double deadline = now_sec() + PING_SPIN_US / 1e6;
+        do {
+            if (__atomic_load_n(word, __ATOMIC_ACQUIRE) == 1) {
+                __atomic_store_n(word, 0, __ATOMIC_RELAXED);
+                return;
+            }
+        } while (now_sec() <= deadline);
+    }
+    if (wake_mech == WAKE_FUTEX) {
+        int idle = 0;
+        while (__atomic_load_n(word, __ATOMIC_ACQUIRE) != 1) {
+            // Announce the sleep; fails (and ends the loop) once the post lands
+            if (__atomic_compare_exchange_n(word, &idle, 2, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) ||
+                idle == 2) {
+                futex_op(word, FUTEX_WAIT, 2);
+            }
+            idle = 0;
+        }
+    } else {
+        pthread_mutex_lock(&d->lock);
+        while (!d->flag) pthread_cond_wait(&d->cond, &d->lock);
+        pthread_mutex_unlock(&d->lock);
+    }
+    __atomic_store_n(word, 0, __ATOMIC_RELAXED);
+}
+
+// Bucket of a latency in ns: exact below 2^PING_SUB_BITS, then
+// 2^PING_SUB_BITS linear steps per power of two
+static int ping_bucket(long ns) {
+    if (ns < (1 << PING_SUB_BITS)) return ns < 0 ? 0 : (int)ns;
+    int msb = 63 - __builtin_clzl(ns);
+    int sub = (int)(ns >> (msb - PING_SUB_BITS)) & ((1 << PING_SUB_BITS) - 1);
+    return ((msb - PING_SUB_BITS + 1) << PING_SUB_BITS) + sub;
+}
+
+// Smallest ns value that lands in bucket b
+static long ping_bucket_low(int b) {
+    if (b < (1 << PING_SUB_BITS)) return b;
+    int msb = (b >> PING_SUB_BITS) + PING_SUB_BITS - 1;
+    long sub = b & ((1 << PING_SUB_BITS) - 1);
+    return (1L << msb) + (sub << (msb - PING_SUB_BITS));
+}
+
+// Upper edge (us) of the bucket holding quantile q
+static double hist_percentile(const long *hist, double q) {
+    long total = 0, seen = 0;
+    for (int b = 0; b < PING_BUCKETS; b++) total += hist[b];
+    long rank = (long)(q * total);
+    if (rank < q * total) rank++; // ceil
+    for (int b = 0; b < PING_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= rank && seen > 0) return (b + 1 < PING_BUCKETS ? ping_bucket_low(b + 1) : ping_bucket_low(b)) / 1e3;
+    }
+    return 0.0;
+}
+
+void ping_run(worker_stats_t *s) {
+    ping_pair_t *pp = &ping_pairs[s->id / 2];
+    int initiator = s->id % 2 == 0;
+
+    for (long i = 0; i < PING_WARMUP + PING_ROUNDS; i++) {
+        if (i == PING_WARMUP) s->work_t0 = now_sec();
+        if (initiator) {
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            door_post(&pp->ping);
+            door_wait(&pp->pong);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            if (i >= PING_WARMUP) {
+                long ns = (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec);
+                pp->hist[ping_bucket(ns)]++;
+            }
+        } else {
+            door_wait(&pp->ping);
+            door_post(&pp->pong);
+        }
+        if (i >= PING_WARMUP) s->ops++;
+    }
+    s->work_t1 = now_sec();
+}
+
+void report_pingpong(const char *program, int count, const worker_stats_t *workers) {
+    char mech[32];
+    long merged[PING_BUCKETS] = {0};
+    long rounds = 0;
+    double first = 0.0, last = 0.0;
+    snprintf(mech, sizeof(mech), "%s%s", wake_mech_names[wake_mech], wake_spin ? "+spin" : "");
+    const char *place = affinity_label();
+
+    for (int p = 0; p <= count / 2; p++) {
+        const long *hist = merged;
+        double t = 0.0;
+        long n = 0;
+        if (p < count / 2) {
+            const worker_stats_t *w = &workers[2 * p];
+            hist = ping_pairs[p].hist;
+            for (int b = 0; b < PING_BUCKETS; b++) merged[b] += hist[b];
+            t = w->work_t1 - w->work_t0;
+            n = w->ops;
+            rounds += n;
+            if (first == 0.0 || w->work_t0 < first) first = w->work_t0;
+            if (w->work_t1 > last) last = w->work_t1;
+        } else {
+            t = last - first;
+            n = rounds;
+        }
+        int top = 0;
+        for (int b = 0; b < PING_BUCKETS; b++) if (hist[b]) top = b;
+        printf("PINGPONG,%s,%s,%s,%d,%d,%.0f,%.2f,%.2f,%.2f,%.2f\n", program, mech, place, count / 2,
+               p < count / 2 ? p : -1, t > 0 ? n / t : 0.0, hist_percentile(hist, 0.50),
+               hist_percentile(hist, 0.99), hist_percentile(hist, 0.999), ping_bucket_low(top + 1) / 1e3);
+    }
+    for (int b = 0; b < PING_BUCKETS; b++) {
+        if (!merged[b]) continue;
+        printf("PINGHIST,%s,%s,%s,%d,%.3f,%.3f,%ld\n", program, mech, place, count / 2,
+               ping_bucket_low(b) / 1e3, ping_bucket_low(b + 1) / 1e3, merged[b]);
+    }
+}
@@ -0,0 +1,32 @@
+// The pingpong job: N pairs (2N workers) bounce a token back and forth.
+// The even worker of each pair posts "ping" and times until "pong" comes
+// back, so every round trip is two wakeups. Wake mechanisms:
+//   futex    - a shared word; the waiter sleeps in FUTEX_WAIT only after
+//              announcing itself, the poster calls FUTEX_WAKE only then
+//   eventfd  - one eventfd per direction
+//   pipe     - one pipe per direction, one byte per post
+//   condvar  - a flag under a process-shared mutex and condition variable
+// "+spin" (e.g. futex+spin) makes the waiter poll for PING_SPIN_US before
+// it blocks. Use -a pair / -a spread to put the two
+// sides of a pair on the same CPU or on different cores.
+#ifndef PINGPONG_H
+#define PINGPONG_H
+
+#include "stats.h"
+
+// "futex", "pipe+spin"
+int select_wake_mech(const char *spec);
+
+int ping_setup(int pairs);
+void ping_release(void);
+
+// One side of a pair; ops are timed round trips in [work_t0, work_t1]
+void ping_run(worker_stats_t *s);
+
+// Per-pair and merged round-trip latency:
+//   PINGPONG,<program>,<mech>,<placement>,<pairs>,<pair>,<round trips/s>,<p50_us>,<p99_us>,<p999_us>,<max_us>
+// then the merged histogram, one line per non-empty bucket:
+//   PINGHIST,<program>,<mech>,<placement>,<pairs>,<low_us>,<high_us>,<count>
+void report_pingpong(const char *program, int count, const worker_stats_t *workers);
+
+#endif
@@ -0,0 +1,132 @@
+#include "scale.h"
+#include <sys/mman.h>
+#include <linux/futex.h>
+
+#define SCALE_HOLD_MS 200       // Time everyone stays alive after the sample
+#define SCALE_LIGHT_US 10000
+#define SCALE_LIGHT_BYTES 4096
+
+typedef struct {
+    int alive;          // Workers checked in (futex word for worker 0)
+    int expected;       // Workers actually created
+    int released;       // Futex word the workers park on
+    double create_t0;
+    double create_s;
+    double release_t;
+    long rss_kb, pss_kb, uss_kb, pte_kb;
+    long kstack_kb, ptables_kb, slab_kb; // System-wide growth while all are alive
+} scale_region_t;
+
+static const char *scale_kernel_keys[] = {"KernelStack", "PageTables", "Slab"};
+static scale_region_t *scale_region = NULL;
+static worker_stats_t *scale_workers = NULL;
+static long scale_base[3];
+long thread_stack_kb = 0;
+
+static void scale_meminfo(long *kb) {
+    for (int k = 0; k < 3; k++) kb[k] = read_proc_kb("/proc/meminfo", scale_kernel_keys[k]);
+}
+
+int scale_setup(worker_stats_t *workers, int count) {
+    scale_region = mmap(NULL, sizeof(scale_region_t), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (scale_region == MAP_FAILED) {
+        perror("mmap failed");
+        scale_region = NULL;
+        return -1;
+    }
+    scale_workers = workers;
+    scale_region->expected = count;
+    scale_meminfo(scale_base);
+    scale_region->create_t0 = now_sec();
+    return 0;
+}
+
+void scale_limit(int n) {
+    if (!scale_region) return;
+    __atomic_store_n(&scale_region->expected, n, __ATOMIC_RELEASE);
+    futex_op(&scale_region->alive, FUTEX_WAKE, 1);
+}
+
+void scale_release(void) {
+    if (!scale_region) return;
+    munmap(scale_region, sizeof(scale_region_t));
+    scale_region = NULL;
+}
+
+// Add Rss/Pss/Uss (Private_*) of one process
+static void smaps_rollup_add(pid_t pid, scale_region_t *r) {
+    char path[64], line[256];
+    long kb;
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "Rss: %ld", &kb) == 1) r->rss_kb += kb;
+        else if (sscanf(line, "Pss: %ld", &kb) == 1) r->pss_kb += kb;
+        else if (sscanf(line, "Private_Clean: %ld", &kb) == 1) r->uss_kb += kb;
+        else if (sscanf(line, "Private_Dirty: %ld", &kb) == 1) r->uss_kb += kb;
+    }
+    fclose(fp);
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    kb = read_proc_kb(path, "VmPTE");
+    if (kb > 0) r->pte_kb += kb;
+}
+
+// Worker 0: wait for everyone, sample, then let them go
+static void scale_coordinate(void) {
+    scale_region_t *r = scale_region;
+    int alive;
+    while ((alive = __atomic_load_n(&r->alive, __ATOMIC_ACQUIRE)) <
+           __atomic_load_n(&r->expected, __ATOMIC_ACQUIRE)) {
+        futex_op(&r->alive, FUTEX_WAIT, alive);
+    }
+    r->create_s = now_sec() - r->create_t0;
+
+    long kb[3];
+    scale_meminfo(kb);
+    r->kstack_kb = kb[0] - scale_base[0];
+    r->ptables_kb = kb[1] - scale_base[1];
+    r->slab_kb = kb[2] - scale_base[2];
+    // Threads share one pid: count each process once
+    for (int i = 0; i < r->expected; i++) {
+        if (i == 0 || scale_workers[i].pid != scale_workers[i - 1].pid) smaps_rollup_add(scale_workers[i].pid, r);
+    }
+
+    struct timespec hold = {0, SCALE_HOLD_MS * 1000000L};
+    nanosleep(&hold, NULL);
+    r->release_t = now_sec();
+    __atomic_store_n(&r->released, 1, __ATOMIC_RELEASE);
+    futex_op(&r->released, FUTEX_WAKE, INT32_MAX);
+}
+
+void scale_run(worker_stats_t *s, int light) {
+    scale_region_t *r = scale_region;
+    s->work_t0 = now_sec();
+    __atomic_add_fetch(&r->alive, 1, __ATOMIC_RELEASE);
+    futex_op(&r->alive, FUTEX_WAKE, 1);
+
+    if (s->id == 0) {
+        scale_coordinate();
+    } else if (!light) {
+        while (!__atomic_load_n(&r->released, __ATOMIC_ACQUIRE)) futex_op(&r->released, FUTEX_WAIT, 0);
+    } else {
+        volatile char buf[SCALE_LIGHT_BYTES];
+        struct timespec tick = {0, SCALE_LIGHT_US * 1000L};
+        while (!__atomic_load_n(&r->released, __ATOMIC_ACQUIRE)) {
+            for (int i = 0; i < SCALE_LIGHT_BYTES; i += 64) buf[i] = (char)(buf[i] + s->ops);
+            s->ops++;
+            nanosleep(&tick, NULL);
+        }
+    }
+    s->work_t1 = now_sec();
+}
+
+void report_scale(const char *program, const char *worker, int count, double teardown_end) {
+    scale_region_t *r = scale_region;
+    long kernel_kb = r->kstack_kb + r->ptables_kb + r->slab_kb;
+    printf("SCALE,%s,%s,%d,%ld,%.3f,%.3f,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%.1f,%.1f\n", program, worker, count,
+           thread_stack_kb, r->create_s * 1e3, (teardown_end - r->release_t) * 1e3, r->rss_kb, r->pss_kb,
+           r->uss_kb, r->pte_kb, r->kstack_kb, r->ptables_kb, r->slab_kb,
+           (double)r->pss_kb / count, (double)kernel_kb / count);
+}
@@ -0,0 +1,34 @@
+// High-count scaling. The idle and light jobs measure what a worker costs
+// just by existing. Every worker checks in and then parks on a shared futex
+// until worker 0 has sampled memory with all of them alive:
+//   idle  - block until released
+//   light - wake every SCALE_LIGHT_US, do a little compute on a small
+//           private buffer, go back to sleep
+// Worker 0 records creation time (first create call to the last check-in),
+// the summed Rss/Pss/Uss from /proc/<pid>/smaps_rollup, VmPTE, and the
+// growth of KernelStack, PageTables and Slab in /proc/meminfo; teardown
+// time runs from the release to the last waitpid()/pthread_join().
+#ifndef SCALE_H
+#define SCALE_H
+
+#include "stats.h"
+
+extern long thread_stack_kb;    // progB -z: pthread stack size, 0 = default
+
+// Call after the stats array exists and just before the first worker is created
+int scale_setup(worker_stats_t *workers, int count);
+
+// Creation stopped early (fork/pthread_create failed): only n workers exist
+void scale_limit(int n);
+
+void scale_release(void);
+
+void scale_run(worker_stats_t *s, int light);
+
+// After all workers were reaped/joined:
+//   SCALE,<program>,<worker>,<N>,<stack_kb>,<create_ms>,<teardown_ms>,<rss_kb>,<pss_kb>,<uss_kb>,
+//         <pte_kb>,<kstack_kb>,<ptables_kb>,<slab_kb>,<pss_per_worker_kb>,<kernel_per_worker_kb>
+// Kernel memory is the system-wide growth of KernelStack+PageTables+Slab.
+void report_scale(const char *program, const char *worker, int count, double teardown_end);
+
+#endif
@@ -0,0 +1,198 @@
+#include "shared.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#ifndef SHARED_RECORDS
+#define SHARED_RECORDS 2000
+#endif
+#define SHARED_FILE "io_shared.dat"
+#define GROUP_RING 1024 // Records the queue holds before writers block
+
+static const char *share_mode_names[] = {"none", "append", "pwrite", "group"};
+share_mode_t share_mode = SHARE_NONE;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // Writer: records queued or stop
+    pthread_cond_t done;        // Workers: batch committed or queue space freed
+    long next_seq;              // Sequence number of the next queued record
+    long taken;                 // Records [0, taken) copied out by the writer
+    long committed;             // Records [0, committed) durable
+    long syncs;
+    long max_batch;
+    int stop;
+    char data[GROUP_RING][IO_RECORD_SIZE];
+} group_queue_t;
+
+static int share_fd = -1;
+static group_queue_t *group_q = NULL;
+static pthread_t group_writer;
+
+int select_share_mode(const char *name) {
+    int m = find_name(share_mode_names, SHARE_GROUP + 1, name);
+    if (m <= SHARE_NONE) {
+        fprintf(stderr, "Unknown shared-file mode: %s\n", name);
+        return -1;
+    }
+    share_mode = (share_mode_t)m;
+    return 0;
+}
+
+static void *group_writer_main(void *arg) {
+    group_queue_t *q = group_q;
+    char *batch = malloc((size_t)GROUP_RING * IO_RECORD_SIZE);
+    if (!batch) return NULL;
+
+    pthread_mutex_lock(&q->lock);
+    while (1) {
+        while (q->taken == q->next_seq && !q->stop) pthread_cond_wait(&q->work, &q->lock);
+        if (q->taken == q->next_seq) break; // Stopped and drained
+
+        long first = q->taken, end = q->next_seq;
+        for (long seq = first; seq < end; seq++) {
+            memcpy(batch + (seq - first) * IO_RECORD_SIZE, q->data[seq % GROUP_RING], IO_RECORD_SIZE);
+        }
+        q->taken = end;
+        pthread_cond_broadcast(&q->done); // Queue space
+        pthread_mutex_unlock(&q->lock);
+
+        // The only writer, so the log is laid out in commit order
+        size_t len = (size_t)(end - first) * IO_RECORD_SIZE;
+        if (pwrite(share_fd, batch, len, first * IO_RECORD_SIZE) != (ssize_t)len) perror("group write failed");
+        fdatasync(share_fd);
+
+        pthread_mutex_lock(&q->lock);
+        q->committed = end;
+        q->syncs++;
+        if (end - first > q->max_batch) q->max_batch = end - first;
+        pthread_cond_broadcast(&q->done);
+    }
+    pthread_mutex_unlock(&q->lock);
+    free(batch);
+    return NULL;
+}
+
+int share_open(void) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | (share_mode == SHARE_APPEND ? O_APPEND : 0);
+    share_fd = open(SHARED_FILE, flags, 0644);
+    if (share_fd < 0) {
+        perror("Cannot open shared file");
+        return -1;
+    }
+    if (share_mode != SHARE_GROUP) return 0;
+
+    group_q = mmap(NULL, sizeof(group_queue_t), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (group_q == MAP_FAILED) {
+        perror("mmap failed");
+        group_q = NULL;
+        return -1;
+    }
+    pthread_mutexattr_t ma;
+    pthread_condattr_t ca;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&group_q->lock, &ma);
+    pthread_cond_init(&group_q->work, &ca);
+    pthread_cond_init(&group_q->done, &ca);
+    pthread_mutexattr_destroy(&ma);
+    pthread_condattr_destroy(&ca);
+
+    if (pthread_create(&group_writer, NULL, group_writer_main, NULL) != 0) {
+        perror("Writer thread creation failed");
+        return -1;
+    }
+    return 0;
+}
+
+void share_close(void) {
+    if (group_q) {
+        pthread_mutex_lock(&group_q->lock);
+        group_q->stop = 1;
+        pthread_cond_signal(&group_q->work);
+        pthread_mutex_unlock(&group_q->lock);
+        pthread_join(group_writer, NULL);
+        pthread_mutex_destroy(&group_q->lock);
+        pthread_cond_destroy(&group_q->work);
+        pthread_cond_destroy(&group_q->done);
+        munmap(group_q, sizeof(group_queue_t));
+        group_q = NULL;
+    }
+    if (share_fd >= 0) {
+        close(share_fd);
+        remove(SHARED_FILE);
+        share_fd = -1;
+    }
+}
+
+// Queue one record and wait until the writer has made it durable
+static void group_commit(const char *record) {
+    group_queue_t *q = group_q;
+    pthread_mutex_lock(&q->lock);
+    while (q->next_seq - q->taken >= GROUP_RING) pthread_cond_wait(&q->done, &q->lock);
+    long seq = q->next_seq++;
+    memcpy(q->data[seq % GROUP_RING], record, IO_RECORD_SIZE);
+    pthread_cond_signal(&q->work);
+    while (q->committed <= seq) pthread_cond_wait(&q->done, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+}
+
+void share_run(worker_stats_t *s, char fill) {
+    double *lat = malloc(sizeof(double) * SHARED_RECORDS);
+    char record[IO_RECORD_SIZE];
+    if (!lat) return;
+    memset(record, fill, IO_RECORD_SIZE);
+    off_t region = (off_t)s->id * SHARED_RECORDS * IO_RECORD_SIZE;
+
+    s->work_t0 = now_sec();
+    for (long i = 0; i < SHARED_RECORDS; i++) {
+        double t0 = now_sec();
+        if (share_mode == SHARE_GROUP) group_commit(record);
+        else {
+            ssize_t n = share_mode == SHARE_APPEND
+                ? write(share_fd, record, IO_RECORD_SIZE)
+                : pwrite(share_fd, record, IO_RECORD_SIZE, region + i * IO_RECORD_SIZE);
+            if (n != IO_RECORD_SIZE || fdatasync(share_fd) < 0) {
+                perror("shared write failed");
+                break;
+            }
+            s->sync_count++;
+        }
+        lat[s->ops++] = (now_sec() - t0) * 1e6;
+    }
+    s->work_t1 = now_sec();
+
+    qsort(lat, s->ops, sizeof(double), cmp_double);
+    s->sync_p50_us = percentile(lat, s->ops, 0.50);
+    s->sync_p99_us = percentile(lat, s->ops, 0.99);
+    s->sync_max_us = s->ops ? lat[s->ops - 1] : 0.0;
+    free(lat);
+}
+
+void report_shared(const char *program, int count, const worker_stats_t *workers) {
+    double records = 0.0, first = 0.0, last = 0.0, p50 = 0.0, p99 = 0.0, max = 0.0;
+    long syncs = group_q ? group_q->syncs : 0;
+    for (int i = 0; i < count; i++) {
+        const worker_stats_t *w = &workers[i];
+        double t = w->work_t1 - w->work_t0;
+        if (t <= 0 || w->ops == 0) continue;
+        printf("SHARED,%s,%s,%d,%d,%.1f,%.3f,%.1f,%.1f,%.1f,%ld\n", program,
+               share_mode_names[share_mode], count, w->id, w->ops / t,
+               w->ops * IO_RECORD_SIZE / t / 1048576, w->sync_p50_us, w->sync_p99_us,
+               w->sync_max_us, w->sync_count);
+        records += w->ops;
+        syncs += w->sync_count;
+        if (w->sync_p50_us > p50) p50 = w->sync_p50_us;
+        if (w->sync_p99_us > p99) p99 = w->sync_p99_us;
+        if (w->sync_max_us > max) max = w->sync_max_us;
+        if (first == 0.0 || w->work_t0 < first) first = w->work_t0;
+        if (w->work_t1 > last) last = w->work_t1;
+    }
+    double span = last - first;
+    printf("SHARED,%s,%s,%d,-1,%.1f,%.3f,%.1f,%.1f,%.1f,%ld\n", program,
+           share_mode_names[share_mode], count, span > 0 ? records / span : 0.0,
+           span > 0 ? records * IO_RECORD_SIZE / span / 1048576 : 0.0, p50, p99, max, syncs);
+}
@@ -0,0 +1,35 @@
+// Shared-file writes. Every worker commits SHARED_RECORDS records to one
+// file, each record durable before the next is written:
+//   append - write() on an O_APPEND descriptor, then fdatasync()
+//   pwrite - pwrite() into the worker's own region, then fdatasync()
+//   group  - hand the record to a writer thread in the main task, which
+//            writes everything queued with one pwrite() and one fdatasync()
+//            per batch. The queue is MAP_SHARED with process-shared mutex and
+//            condition variables, so forked workers use it like threads do.
+#ifndef SHARED_H
+#define SHARED_H
+
+#include "stats.h"
+
+typedef enum { SHARE_NONE, SHARE_APPEND, SHARE_PWRITE, SHARE_GROUP } share_mode_t;
+
+extern share_mode_t share_mode;
+
+int select_share_mode(const char *name);
+
+// Create the shared file (and the group-commit queue and writer) before
+// the workers start
+int share_open(void);
+void share_close(void);
+
+// One worker's share of the shared-file job; ops are records committed,
+// sync_* the per-record commit latency
+void share_run(worker_stats_t *s, char fill);
+
+// Commit throughput and latency, one line per worker and an aggregate line
+// (id -1: all records over the span from the first start to the last end,
+// latencies of the worst worker, syncs including the group writer's):
+//   SHARED,<program>,<mode>,<N>,<id>,<records/s>,<MB/s>,<p50_us>,<p99_us>,<max_us>,<syncs>
+void report_shared(const char *program, int count, const worker_stats_t *workers);
+
+#endif
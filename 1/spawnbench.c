@@ -0,0 +1,35 @@
+#include "spawnbench.h"
+#include "pages.h"
+
+long spawn_rss_mb = 0;
+
+int spawn_bench(const char *program, const char *primitive, int n, spawn_fn spawn_once) {
+    size_t rss = (size_t)spawn_rss_mb << 20;
+    char *buf = NULL;
+    if (rss > 0) {
+        buf = page_map(rss);
+        if (!buf) return -1;
+        for (size_t off = 0; off < rss; off += MEM_PAGE) buf[off] = 1;
+    }
+
+    double *start = malloc(sizeof(double) * n), *reap = malloc(sizeof(double) * n);
+    if (!start || !reap) return -1;
+    double warm_start, warm_reap;
+    int failed = spawn_once(&warm_start, &warm_reap) < 0;
+    for (int i = 0; i < n && !failed; i++) failed = spawn_once(&start[i], &reap[i]) < 0;
+    if (failed) perror("spawn failed");
+
+    if (!failed) {
+        qsort(start, n, sizeof(double), cmp_double);
+        qsort(reap, n, sizeof(double), cmp_double);
+        printf("SPAWN,%s,%s,%s,%ld,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%ld\n", program, primitive,
+               page_label(), spawn_rss_mb, n, percentile(start, n, 0.50) * 1e6,
+               percentile(start, n, 0.99) * 1e6, start[n - 1] * 1e6,
+               percentile(reap, n, 0.50) * 1e6, percentile(reap, n, 0.99) * 1e6,
+               reap[n - 1] * 1e6, read_proc_kb("/proc/self/status", "VmPTE"));
+    }
+    free(start);
+    free(reap);
+    page_unmap(buf, rss);
+    return failed ? -1 : 0;
+}
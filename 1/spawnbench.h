@@ -0,0 +1,22 @@
+// Spawn cost: spawn mode creates N workers one at a time from a parent
+// holding a touched buffer of -R MB (mapped under the -g page policy) and
+// times each one:
+//   start - from the create call to the child's first instruction
+//   reap  - from the create call until the child has been waited for/joined
+// The primitives live in A.c (processes) and B.c (pthread_create).
+#ifndef SPAWNBENCH_H
+#define SPAWNBENCH_H
+
+#include "common.h"
+
+extern long spawn_rss_mb;
+
+// One spawn: fills start/reap in seconds, returns -1 on failure
+typedef int (*spawn_fn)(double *start, double *reap);
+
+// Time n spawns (after one warm-up) and print
+//   SPAWN,<program>,<primitive>,<pages>,<rss_mb>,<n>,<start_p50_us>,<start_p99_us>,
+//         <start_max_us>,<reap_p50_us>,<reap_p99_us>,<reap_max_us>,<pte_kb>
+int spawn_bench(const char *program, const char *primitive, int n, spawn_fn spawn_once);
+
+#endif
@@ -0,0 +1,134 @@
+#include "stats.h"
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+static pid_t get_tid(void) {
+    return (pid_t)syscall(SYS_gettid);
+}
+
+static double tv_sec(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Per-task I/O counters from /proc/<pid>/task/<tid>/io:
+// read_bytes, write_bytes, rchar, wchar (zero if unavailable)
+static void read_task_io(pid_t pid, pid_t tid, long long out[4]) {
+    char path[64], key[32];
+    long long value;
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/io", pid, tid);
+    memset(out, 0, 4 * sizeof(long long));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    while (fscanf(fp, "%31s %lld", key, &value) == 2) {
+        if (strcmp(key, "read_bytes:") == 0) out[0] = value;
+        else if (strcmp(key, "write_bytes:") == 0) out[1] = value;
+        else if (strcmp(key, "rchar:") == 0) out[2] = value;
+        else if (strcmp(key, "wchar:") == 0) out[3] = value;
+    }
+    fclose(fp);
+}
+
+// Last CPU the task ran on: field 39 of /proc/<pid>/task/<tid>/stat
+static int read_task_cpu(pid_t pid, pid_t tid) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    // comm (field 2) may contain spaces, so count fields after the last ')'
+    char *p = strrchr(buf, ')');
+    if (!p) return -1;
+    int field = 2, cpu = -1;
+    for (char *tok = strtok(p + 1, " "); tok; tok = strtok(NULL, " ")) {
+        if (++field == 39) {
+            cpu = atoi(tok);
+            break;
+        }
+    }
+    return cpu;
+}
+
+void stats_begin(worker_stats_t *s, int id, int who) {
+    memset(s, 0, sizeof(*s));
+    s->id = id;
+    s->pid = getpid();
+    s->tid = get_tid();
+    read_task_io(s->pid, s->tid, s->io0);
+    getrusage(who, &s->ru0);
+    s->t0 = now_sec();
+}
+
+void stats_end(worker_stats_t *s, int who) {
+    struct rusage ru;
+    long long io[4];
+
+    s->wall_s = now_sec() - s->t0;
+    getrusage(who, &ru);
+    read_task_io(s->pid, s->tid, io);
+
+    s->user_s = tv_sec(ru.ru_utime) - tv_sec(s->ru0.ru_utime);
+    s->sys_s = tv_sec(ru.ru_stime) - tv_sec(s->ru0.ru_stime);
+    s->maxrss_kb = ru.ru_maxrss;
+    s->minflt = ru.ru_minflt - s->ru0.ru_minflt;
+    s->majflt = ru.ru_majflt - s->ru0.ru_majflt;
+    s->nvcsw = ru.ru_nvcsw - s->ru0.ru_nvcsw;
+    s->nivcsw = ru.ru_nivcsw - s->ru0.ru_nivcsw;
+    s->read_bytes = io[0] - s->io0[0];
+    s->write_bytes = io[1] - s->io0[1];
+    s->rchar = io[2] - s->io0[2];
+    s->wchar = io[3] - s->io0[3];
+    s->cpu = read_task_cpu(s->pid, s->tid);
+}
+
+FILE *stats_open(const char *path) {
+    FILE *fp = fopen(path, "a");
+    if (!fp) {
+        perror("Cannot open stats file");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0 && st.st_size == 0) {
+        fprintf(fp, "run_id,program,worker,count,scope,id,pid,tid,cpu,wall_s,user_s,sys_s,"
+                    "cpu_pct,maxrss_kb,minflt,majflt,nvcsw,nivcsw,read_bytes,write_bytes,"
+                    "rchar,wchar,ops\n");
+    }
+    return fp;
+}
+
+void stats_write(FILE *fp, const char *run_id, const char *program, const char *worker,
+                 int count, const char *scope, const worker_stats_t *s) {
+    double cpu_pct = s->wall_s > 0 ? 100.0 * (s->user_s + s->sys_s) / s->wall_s : 0.0;
+    fprintf(fp, "%s,%s,%s,%d,%s,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.2f,%ld,%ld,%ld,%ld,%ld,"
+                "%lld,%lld,%lld,%lld,%lld\n",
+            run_id, program, worker, count, scope, s->id, s->pid, s->tid, s->cpu,
+            s->wall_s, s->user_s, s->sys_s, cpu_pct, s->maxrss_kb, s->minflt, s->majflt,
+            s->nvcsw, s->nivcsw, s->read_bytes, s->write_bytes, s->rchar, s->wchar, s->ops);
+}
+
+void stats_add_children(worker_stats_t *run) {
+    struct rusage ru;
+    getrusage(RUSAGE_CHILDREN, &ru);
+    run->user_s += tv_sec(ru.ru_utime);
+    run->sys_s += tv_sec(ru.ru_stime);
+    run->minflt += ru.ru_minflt;
+    run->majflt += ru.ru_majflt;
+    run->nvcsw += ru.ru_nvcsw;
+    run->nivcsw += ru.ru_nivcsw;
+}
+
+void stats_sum_io(worker_stats_t *run, const worker_stats_t *workers, int n) {
+    run->read_bytes = run->write_bytes = run->rchar = run->wchar = run->ops = 0;
+    for (int i = 0; i < n; i++) {
+        run->ops += workers[i].ops;
+        run->read_bytes += workers[i].read_bytes;
+        run->write_bytes += workers[i].write_bytes;
+        run->rchar += workers[i].rchar;
+        run->wchar += workers[i].wchar;
+    }
+    run->cpu = -1;
+}
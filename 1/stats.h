@@ -0,0 +1,62 @@
+// In-process resource accounting: every worker (and the whole run) records
+// its own wall time, getrusage(), /proc task I/O counters and last CPU
+#ifndef STATS_H
+#define STATS_H
+
+#include "common.h"
+#include <sys/resource.h>
+
+#define STATS_DEFAULT_FILE "worker_stats.csv"
+
+// Everything one worker (or one whole run) measured about itself
+typedef struct {
+    int id;             // Worker index, -1 for the run row
+    pid_t pid;
+    pid_t tid;
+    int cpu;            // CPU the task last ran on
+    double wall_s;
+    double user_s;
+    double sys_s;
+    long maxrss_kb;
+    long minflt;
+    long majflt;
+    long nvcsw;         // Voluntary context switches
+    long nivcsw;        // Involuntary context switches
+    long long read_bytes;   // Bytes that reached the block layer
+    long long write_bytes;
+    long long rchar;        // Bytes passed to read()/write() style calls
+    long long wchar;
+    long long ops;          // Work items completed (chunks in strong mode)
+    double work_t0;         // Measured kernel window (memory kernels), CLOCK_MONOTONIC
+    double work_t1;
+    long pte_kb;            // VmPTE (page tables) at the end of a memory kernel
+    long thp_kb;            // AnonHugePages at the end of a memory kernel
+    long sync_count;        // Sync calls made by an I/O engine / shared-file run
+    double sync_p50_us;
+    double sync_p99_us;
+    double sync_max_us;
+    // Internal: values at stats_begin()
+    double t0;
+    struct rusage ru0;
+    long long io0[4];
+} worker_stats_t;
+
+// who = RUSAGE_SELF for a forked worker, RUSAGE_THREAD for a pthread
+void stats_begin(worker_stats_t *s, int id, int who);
+void stats_end(worker_stats_t *s, int who);
+
+// Open the stats CSV for appending, writing the header on a new file
+FILE *stats_open(const char *path);
+
+// scope is "worker" for per-worker rows and "run" for the whole run
+void stats_write(FILE *fp, const char *run_id, const char *program, const char *worker,
+                 int count, const char *scope, const worker_stats_t *s);
+
+// Add the usage of reaped child processes (RUSAGE_CHILDREN) to a run row
+void stats_add_children(worker_stats_t *run);
+
+// The run row's I/O and ops are the sum over its workers (per-task counters do not
+// include other tasks, and the main task's own counters are a worker's)
+void stats_sum_io(worker_stats_t *run, const worker_stats_t *workers, int n);
+
+#endif
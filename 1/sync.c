@@ -0,0 +1,150 @@
+#include "sync.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <linux/futex.h>
+
+#ifndef SYNC_OPS
+#define SYNC_OPS 2000000L
+#endif
+
+typedef enum { SYNC_MUTEX, SYNC_SPIN, SYNC_FUTEX, SYNC_ATOMIC, SYNC_PADDED, SYNC_FALSE } sync_variant_t;
+
+static const char *sync_variant_names[] = {"mutex", "spin", "futex", "atomic", "padded", "false"};
+static sync_variant_t sync_variant = SYNC_MUTEX;
+
+typedef struct {
+    volatile long value;
+    char pad[CACHE_LINE - sizeof(long)];
+} padded_counter_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_spinlock_t spin;
+    int futex_word;     // 0 unlocked, 1 locked, 2 locked with waiters
+    char pad0[CACHE_LINE];
+    long counter __attribute__((aligned(CACHE_LINE)));
+    char pad1[CACHE_LINE - sizeof(long)];
+    padded_counter_t padded[];  // count entries, then count packed longs
+} sync_region_t;
+
+static sync_region_t *sync_region = NULL;
+static size_t sync_region_size = 0;
+static int sync_workers = 0;
+
+int select_sync_variant(const char *name) {
+    int v = find_name(sync_variant_names, SYNC_FALSE + 1, name);
+    if (v < 0) {
+        fprintf(stderr, "Unknown sync variant: %s\n", name);
+        return -1;
+    }
+    sync_variant = (sync_variant_t)v;
+    return 0;
+}
+
+static volatile long *sync_packed(void) {
+    return (volatile long *)&sync_region->padded[sync_workers];
+}
+
+static void futex_lock(int *f) {
+    int c = 0;
+    if (__atomic_compare_exchange_n(f, &c, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return;
+    if (c != 2) c = __atomic_exchange_n(f, 2, __ATOMIC_ACQUIRE);
+    while (c != 0) {
+        futex_op(f, FUTEX_WAIT, 2);
+        c = __atomic_exchange_n(f, 2, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void futex_unlock(int *f) {
+    if (__atomic_fetch_sub(f, 1, __ATOMIC_RELEASE) != 1) {
+        __atomic_store_n(f, 0, __ATOMIC_RELEASE);
+        futex_op(f, FUTEX_WAKE, 1);
+    }
+}
+
+int sync_setup(int count) {
+    sync_workers = count;
+    sync_region_size = sizeof(sync_region_t) + count * sizeof(padded_counter_t) + count * sizeof(long);
+    sync_region = mmap(NULL, sync_region_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sync_region == MAP_FAILED) {
+        perror("mmap failed");
+        sync_region = NULL;
+        return -1;
+    }
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&sync_region->mutex, &ma);
+    pthread_mutexattr_destroy(&ma);
+    pthread_spin_init(&sync_region->spin, PTHREAD_PROCESS_SHARED);
+    return 0;
+}
+
+void sync_release(void) {
+    if (!sync_region) return;
+    pthread_mutex_destroy(&sync_region->mutex);
+    pthread_spin_destroy(&sync_region->spin);
+    munmap(sync_region, sync_region_size);
+    sync_region = NULL;
+}
+
+void sync_run(worker_stats_t *s) {
+    sync_region_t *r = sync_region;
+    volatile long *mine = sync_variant == SYNC_PADDED ? &r->padded[s->id].value : &sync_packed()[s->id];
+
+    s->work_t0 = now_sec();
+    for (long i = 0; i < SYNC_OPS; i++) {
+        if (sync_variant == SYNC_MUTEX) {
+            pthread_mutex_lock(&r->mutex);
+            r->counter++;
+            pthread_mutex_unlock(&r->mutex);
+        } else if (sync_variant == SYNC_SPIN) {
+            pthread_spin_lock(&r->spin);
+            r->counter++;
+            pthread_spin_unlock(&r->spin);
+        } else if (sync_variant == SYNC_FUTEX) {
+            futex_lock(&r->futex_word);
+            r->counter++;
+            futex_unlock(&r->futex_word);
+        } else if (sync_variant == SYNC_ATOMIC) {
+            __atomic_fetch_add(&r->counter, 1, __ATOMIC_RELAXED);
+        } else {
+            (*mine)++;
+        }
+    }
+    s->work_t1 = now_sec();
+    s->ops = SYNC_OPS;
+}
+
+int report_sync(const char *program, int count, const worker_stats_t *workers) {
+    double ops = 0.0, first = 0.0, last = 0.0;
+    for (int i = 0; i < count; i++) {
+        const worker_stats_t *w = &workers[i];
+        double t = w->work_t1 - w->work_t0;
+        if (t <= 0 || w->ops == 0) continue;
+        printf("SYNC,%s,%s,%d,%d,%.0f,%.2f\n", program, sync_variant_names[sync_variant], count,
+               w->id, w->ops / t, t * 1e9 / w->ops);
+        ops += w->ops;
+        if (first == 0.0 || w->work_t0 < first) first = w->work_t0;
+        if (w->work_t1 > last) last = w->work_t1;
+    }
+    double span = last - first;
+    printf("SYNC,%s,%s,%d,-1,%.0f,%.2f\n", program, sync_variant_names[sync_variant], count,
+           span > 0 ? ops / span : 0.0, ops > 0 ? span * 1e9 / ops : 0.0);
+
+    long total = 0;
+    if (sync_variant == SYNC_PADDED || sync_variant == SYNC_FALSE) {
+        for (int i = 0; i < count; i++) {
+            total += sync_variant == SYNC_PADDED ? sync_region->padded[i].value : sync_packed()[i];
+        }
+    } else {
+        total = sync_region->counter;
+    }
+    if (total != (long)count * SYNC_OPS) {
+        fprintf(stderr, "sync %s: counted %ld of %ld increments\n",
+                sync_variant_names[sync_variant], total, (long)count * SYNC_OPS);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+// The sync job: every worker performs SYNC_OPS increments on state shared
+// with the other workers. The region is MAP_SHARED, so forked workers and
+// threads run exactly the same code; locks are PTHREAD_PROCESS_SHARED and
+// the futex lock uses shared (not _PRIVATE) futex operations.
+//   mutex  - one counter under a pthread mutex
+//   spin   - one counter under a pthread spinlock
+//   futex  - one counter under a futex-based mutex (Drepper's "mutex 2")
+//   atomic - one counter, __atomic_fetch_add
+//   padded - one counter per worker, each on its own cache line
+//   false  - one counter per worker, packed into shared cache lines
+#ifndef SYNC_H
+#define SYNC_H
+
+#include "stats.h"
+
+int select_sync_variant(const char *name);
+
+// Map and initialise the shared region for count workers
+int sync_setup(int count);
+void sync_release(void);
+
+void sync_run(worker_stats_t *s);
+
+// Increments per second, one line per worker and an aggregate line (id -1,
+// all increments over the span from the first start to the last end):
+//   SYNC,<program>,<variant>,<N>,<id>,<ops/s>,<ns/op>
+// Returns -1 if the shared state lost increments.
+int report_sync(const char *program, int count, const worker_stats_t *workers);
+
+#endif
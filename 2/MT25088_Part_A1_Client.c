@@ -1,10 +1,11 @@
 // MT25XXX_PartB_Client.c - Replace XXX with your roll number
-#include "common.h"
+#include "MT25088_Part_A_common.h"
 #include <sys/time.h>
 
 // Arguments structure
 typedef struct {
     char *server_ip;
+    const char *strategy;
     int message_size;
     int duration;
     long long bytes_received;
@@ -30,6 +31,10 @@ void *client_thread(void *arg) {
         return NULL;
     }
     
+    // Set socket options before connect so the receive window scale
+    // negotiated in the handshake matches the tuned SO_RCVBUF
+    set_socket_options_tuned(sock, args->strategy, args->message_size);
+
     serv_addr.sin_family = AF_INET;
     serv_addr.sin_port = htons(PORT);
     
@@ -45,9 +50,6 @@ void *client_thread(void *arg) {
         return NULL;
     }
 
-    // Set socket options
-    set_socket_options(sock);
-
     // Send message size to server
     size_t msg_size = args->message_size;
     if (send(sock, &msg_size, sizeof(msg_size), 0) != sizeof(msg_size)) {
@@ -90,8 +92,8 @@ void *client_thread(void *arg) {
 }
 
 int main(int argc, char const *argv[]) {
-    if (argc != 5) {
-        fprintf(stderr, "Usage: %s <Server IP> <Threads> <Msg Size> <Duration (s)>\n", argv[0]);
+    if (argc != 5 && argc != 6) {
+        fprintf(stderr, "Usage: %s <Server IP> <Threads> <Msg Size> <Duration (s)> [Strategy]\n", argv[0]);
         return -1;
     }
 
@@ -99,6 +101,8 @@ int main(int argc, char const *argv[]) {
     int thread_count = atoi(argv[2]);
     int message_size = atoi(argv[3]);
     int duration = atoi(argv[4]);
+    // Strategy selects the socket profile entry ("*" = any strategy)
+    const char *strategy = (argc == 6) ? argv[5] : "*";
 
     // Validate inputs
     if (thread_count <= 0 || thread_count > 100) {
@@ -112,6 +116,8 @@ int main(int argc, char const *argv[]) {
         return -1;
     }
 
+    load_socket_profile();
+
     pthread_t *threads = malloc(sizeof(pthread_t) * thread_count);
     thread_args_t *t_args = malloc(sizeof(thread_args_t) * thread_count);
 
@@ -123,6 +129,7 @@ int main(int argc, char const *argv[]) {
     // Start all threads
     for (int i = 0; i < thread_count; i++) {
         t_args[i].server_ip = server_ip;
+        t_args[i].strategy = strategy;
         t_args[i].message_size = message_size;
         t_args[i].duration = duration;
         t_args[i].bytes_received = 0;
@@ -1,5 +1,5 @@
 // MT25XXX_PartA1_Server.c - Replace XXX with your roll number
-#include "common.h"
+#include "MT25088_Part_A_common.h"
 
 void *handle_client(void *arg) {
     int client_fd = *(int *)arg;
@@ -35,7 +35,7 @@ void *handle_client(void *arg) {
     }
 
     // Set socket options
-    set_socket_options(client_fd);
+    set_socket_options_tuned(client_fd, "two-copy", total_payload_size);
 
     // Keep sending until client disconnects or error
     while (1) {
@@ -94,6 +94,9 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
     printf("Server (A1 Two-Copy) listening on port %d...\n", PORT);
 
     while (1) {
@@ -1,5 +1,5 @@
 // MT25XXX_PartA2_Server.c - Replace XXX with your roll number
-#include "common.h"
+#include "MT25088_Part_A_common.h"
 #include <sys/uio.h> // Required for struct iovec
 
 void *handle_client(void *arg) {
@@ -41,7 +41,7 @@ void *handle_client(void *arg) {
     msg_header.msg_iovlen = NUM_FIELDS;
 
     // Set socket options
-    set_socket_options(client_fd);
+    set_socket_options_tuned(client_fd, "one-copy", total_payload_size);
 
     // Keep sending
     while (1) {
@@ -93,6 +93,9 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
     printf("Server (A2 One-Copy) listening on port %d...\n", PORT);
 
     while (1) {
@@ -1,5 +1,5 @@
 // MT25XXX_PartA3_Server.c - Replace XXX with your roll number
-#include "common.h"
+#include "MT25088_Part_A_common.h"
 #include <sys/uio.h>
 #include <linux/errqueue.h>
 #include <fcntl.h>
@@ -87,7 +87,7 @@ void *handle_client(void *arg) {
     msg_header.msg_iovlen = NUM_FIELDS;
 
     // Set socket options
-    set_socket_options(client_fd);
+    set_socket_options_tuned(client_fd, "zero-copy", total_payload_size);
 
     // Track pending notifications
     int pending_notifications = 0;
@@ -159,6 +159,9 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
     printf("Server (A3 Zero-Copy) listening on port %d...\n", PORT);
 
     while (1) {
@@ -0,0 +1,354 @@
+// MT25088_PartA4_Server.c - File-backed payload (sendfile / splice)
+#define _GNU_SOURCE // memfd_create(), splice()
+#include "MT25088_Part_A_common.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifndef F_SETPIPE_SZ
+#define F_SETPIPE_SZ 1031
+#endif
+
+// Where the eight fields live, and how they are pushed to the socket
+typedef enum { BACKING_MEMFD, BACKING_TMPFS, BACKING_DISK } backing_t;
+typedef enum { METHOD_SENDFILE, METHOD_SPLICE } method_t;
+
+backing_t backing = BACKING_MEMFD;
+method_t method = METHOD_SENDFILE;
+int cold_cache = 0; // Drop the fields from the page cache after every message
+const char *disk_dir = ".";
+
+// The MessageStruct equivalent for file-backed data: one fd per field
+typedef struct {
+    int fds[NUM_FIELDS];
+    size_t field_sizes[NUM_FIELDS];
+} FileMessage;
+
+int create_field_fd(int index) {
+    if (backing == BACKING_MEMFD) {
+        char name[32];
+        snprintf(name, sizeof(name), "field_%d", index);
+        return memfd_create(name, MFD_CLOEXEC);
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/a4_field_XXXXXX",
+             backing == BACKING_TMPFS ? "/dev/shm" : disk_dir);
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path); // Keep only the open descriptor
+    return fd;
+}
+
+// Same layout and fill pattern as allocate_message(), but stored in files
+void allocate_file_message(FileMessage *msg, size_t total_size) {
+    if (total_size < MIN_MSG_SIZE || total_size > MAX_MSG_SIZE) {
+        fprintf(stderr, "Invalid message size: %zu (must be between %d and %d)\n",
+                total_size, MIN_MSG_SIZE, MAX_MSG_SIZE);
+        exit(1);
+    }
+
+    size_t chunk_size = total_size / NUM_FIELDS;
+    char *chunk = malloc(chunk_size);
+    if (!chunk) {
+        perror("Malloc failed");
+        exit(1);
+    }
+
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        msg->field_sizes[i] = chunk_size;
+        msg->fds[i] = create_field_fd(i);
+        if (msg->fds[i] < 0) {
+            perror("Field file creation failed");
+            exit(1);
+        }
+
+        memset(chunk, 'A' + i, chunk_size);
+        size_t written = 0;
+        while (written < chunk_size) {
+            ssize_t n = pwrite(msg->fds[i], chunk + written, chunk_size - written, written);
+            if (n <= 0) {
+                perror("Field write failed");
+                exit(1);
+            }
+            written += n;
+        }
+        // Clean pages can be evicted by POSIX_FADV_DONTNEED in cold-cache mode
+        if (backing == BACKING_DISK) fsync(msg->fds[i]);
+    }
+    free(chunk);
+}
+
+void free_file_message(FileMessage *msg) {
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        if (msg->fds[i] >= 0) {
+            close(msg->fds[i]);
+            msg->fds[i] = -1;
+        }
+    }
+}
+
+// Send one field with sendfile(), looping over partial transfers
+int send_field_sendfile(int client_fd, int field_fd, size_t size) {
+    off_t offset = 0;
+    while ((size_t)offset < size) {
+        ssize_t sent = sendfile(client_fd, field_fd, &offset, size - offset);
+        if (sent <= 0) return -1;
+    }
+    return 0;
+}
+
+// Send one field file -> pipe -> socket with splice(); the data never
+// enters user space
+int send_field_splice(int client_fd, int field_fd, size_t size, int pipe_fds[2]) {
+    loff_t offset = 0;
+    while ((size_t)offset < size) {
+        ssize_t in_pipe = splice(field_fd, &offset, pipe_fds[1], NULL, size - offset,
+                                 SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (in_pipe <= 0) return -1;
+
+        while (in_pipe > 0) {
+            ssize_t sent = splice(pipe_fds[0], NULL, client_fd, NULL, in_pipe,
+                                  SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (sent <= 0) return -1;
+            in_pipe -= sent;
+        }
+    }
+    return 0;
+}
+
+// Cold-cache case: pages still referenced by unacknowledged skbs are
+// skipped by POSIX_FADV_DONTNEED, so wait for the send queue (SIOCOUTQ) to
+// drain first. Bounded, so a stalled client cannot wedge the thread.
+void wait_send_queue_drained(int fd) {
+    for (int i = 0; i < 1000; i++) {
+        int queued = 0;
+        if (ioctl(fd, SIOCOUTQ, &queued) < 0 || queued == 0) return;
+        usleep(100);
+    }
+}
+
+// Pages of one field still in the page cache (mincore() on a mapping of it)
+long cached_pages(void *map, size_t size, unsigned char *vec) {
+    long page = sysconf(_SC_PAGESIZE);
+    long pages = (size + page - 1) / page, cached = 0;
+    if (mincore(map, size, vec) < 0) return 0;
+    for (long i = 0; i < pages; i++) cached += vec[i] & 1;
+    return cached;
+}
+
+void *handle_client(void *arg) {
+    int client_fd = *(int *)arg;
+    free(arg);
+
+    // 1. Receive message size from client
+    size_t total_payload_size;
+    ssize_t received = recv(client_fd, &total_payload_size, sizeof(total_payload_size), 0);
+    if (received != sizeof(total_payload_size)) {
+        perror("Failed to receive message size");
+        close(client_fd);
+        return NULL;
+    }
+
+    // Validate message size
+    if (total_payload_size < MIN_MSG_SIZE || total_payload_size > MAX_MSG_SIZE) {
+        fprintf(stderr, "Invalid message size received: %zu\n", total_payload_size);
+        close(client_fd);
+        return NULL;
+    }
+
+    // 2. Setup Data: the eight fields live in files instead of heap buffers
+    FileMessage msg;
+    allocate_file_message(&msg, total_payload_size);
+
+    int pipe_fds[2] = {-1, -1};
+    if (method == METHOD_SPLICE) {
+        if (pipe(pipe_fds) < 0) {
+            perror("Pipe creation failed");
+            free_file_message(&msg);
+            close(client_fd);
+            return NULL;
+        }
+        // Larger pipe = fewer splice round trips per field (best effort)
+        fcntl(pipe_fds[1], F_SETPIPE_SZ, 1024 * 1024);
+    }
+
+    // The tuner has no sendfile/splice entries; like A2, one kernel-side
+    // pass moves the payload, so use the one-copy settings
+    set_socket_options_tuned(client_fd, "one-copy", total_payload_size);
+
+    // Cold case: map the fields once to check how much eviction really evicts
+    void *maps[NUM_FIELDS] = {NULL};
+    unsigned char *vec = NULL;
+    long evict_pages = 0, still_cached = 0, messages = 0;
+    time_t last_report = time(NULL);
+    if (cold_cache) {
+        long page = sysconf(_SC_PAGESIZE);
+        vec = malloc((msg.field_sizes[0] + page - 1) / page);
+        for (int i = 0; i < NUM_FIELDS; i++) {
+            maps[i] = mmap(NULL, msg.field_sizes[i], PROT_READ, MAP_SHARED, msg.fds[i], 0);
+            if (maps[i] == MAP_FAILED) maps[i] = NULL;
+        }
+    }
+
+    int cork = 1, uncork = 0;
+    while (1) {
+        // --- NO USER-SPACE COPY: page cache -> socket inside the kernel ---
+        // Cork so the eight per-field transfers leave as full segments
+        if (method == METHOD_SENDFILE) {
+            setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork));
+        }
+
+        int failed = 0;
+        for (int i = 0; i < NUM_FIELDS && !failed; i++) {
+            if (method == METHOD_SENDFILE) {
+                failed = send_field_sendfile(client_fd, msg.fds[i], msg.field_sizes[i]) < 0;
+            } else {
+                failed = send_field_splice(client_fd, msg.fds[i], msg.field_sizes[i], pipe_fds) < 0;
+            }
+        }
+
+        if (method == METHOD_SENDFILE) {
+            setsockopt(client_fd, IPPROTO_TCP, TCP_CORK, &uncork, sizeof(uncork));
+        }
+        if (failed) break; // Client closed or error
+
+        // Cold-cache case: every message has to be read back from the device
+        if (cold_cache) {
+            wait_send_queue_drained(client_fd);
+            messages++;
+            for (int i = 0; i < NUM_FIELDS; i++) {
+                posix_fadvise(msg.fds[i], 0, 0, POSIX_FADV_DONTNEED);
+                if (maps[i] && vec) {
+                    long page = sysconf(_SC_PAGESIZE);
+                    evict_pages += (msg.field_sizes[i] + page - 1) / page;
+                    still_cached += cached_pages(maps[i], msg.field_sizes[i], vec);
+                }
+            }
+
+            // Pages the peer has not consumed yet (e.g. unread on the loopback
+            // receive queue) stay cached, so report how cold the case really
+            // is, once a second (the server exits on SIGPIPE at the end):
+            // COLD,<messages>,<pages_evicted>,<pages_still_cached>,<still_cached_pct>
+            if (time(NULL) != last_report) {
+                last_report = time(NULL);
+                printf("COLD,%ld,%ld,%ld,%.1f\n", messages, evict_pages, still_cached,
+                       evict_pages ? 100.0 * still_cached / evict_pages : 0.0);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (cold_cache) {
+        for (int i = 0; i < NUM_FIELDS; i++) {
+            if (maps[i]) munmap(maps[i], msg.field_sizes[i]);
+        }
+        free(vec);
+    }
+
+    if (pipe_fds[0] >= 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+    free_file_message(&msg);
+    close(client_fd);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int server_fd, *new_sock;
+    struct sockaddr_in address;
+    int addrlen = sizeof(address);
+
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [memfd|tmpfs|disk|disk-cold] [sendfile|splice]\n", argv[0]);
+        return -1;
+    }
+    if (argc > 1) {
+        if (strcmp(argv[1], "memfd") == 0) backing = BACKING_MEMFD;
+        else if (strcmp(argv[1], "tmpfs") == 0) backing = BACKING_TMPFS;
+        else if (strcmp(argv[1], "disk") == 0) backing = BACKING_DISK;
+        else if (strcmp(argv[1], "disk-cold") == 0) {
+            backing = BACKING_DISK;
+            cold_cache = 1;
+        } else {
+            fprintf(stderr, "Unknown backing: %s\n", argv[1]);
+            return -1;
+        }
+    }
+    if (argc > 2) {
+        if (strcmp(argv[2], "sendfile") == 0) method = METHOD_SENDFILE;
+        else if (strcmp(argv[2], "splice") == 0) method = METHOD_SPLICE;
+        else {
+            fprintf(stderr, "Unknown method: %s\n", argv[2]);
+            return -1;
+        }
+    }
+    // Directory for the disk backing (must not be tmpfs for the cold case)
+    if (getenv("MT25088_A4_DIR")) disk_dir = getenv("MT25088_A4_DIR");
+
+    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+        perror("Socket failed");
+        exit(EXIT_FAILURE);
+    }
+
+    int opt = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt failed");
+        exit(EXIT_FAILURE);
+    }
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(PORT);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (listen(server_fd, 10) < 0) {
+        perror("Listen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
+    printf("Server (A4 %s, %s%s) listening on port %d...\n",
+           method == METHOD_SPLICE ? "splice" : "sendfile",
+           backing == BACKING_MEMFD ? "memfd" : backing == BACKING_TMPFS ? "tmpfs" : "disk",
+           cold_cache ? ", cold cache" : "", PORT);
+
+    while (1) {
+        new_sock = malloc(sizeof(int));
+        if (!new_sock) {
+            perror("Malloc failed");
+            continue;
+        }
+
+        *new_sock = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen);
+        if (*new_sock < 0) {
+            perror("Accept failed");
+            free(new_sock);
+            continue;
+        }
+
+        pthread_t thread_id;
+        if (pthread_create(&thread_id, NULL, handle_client, (void *)new_sock) < 0) {
+            perror("Thread creation failed");
+            close(*new_sock);
+            free(new_sock);
+            continue;
+        }
+        pthread_detach(thread_id);
+    }
+
+    close(server_fd);
+    return 0;
+}
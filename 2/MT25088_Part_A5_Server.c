@@ -0,0 +1,474 @@
+// MT25088_PartA5_Server.c - Broadcast: pub/sub fan-out from a shared buffer pool
+#define _GNU_SOURCE
+#include "MT25088_Part_A_common.h"
+#include <sys/uio.h>
+#include <poll.h>
+#include <linux/errqueue.h>
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+// One producer publishes numbered messages into a ring of POOL_SLOTS
+// preallocated MessageStructs. Every connection is a subscriber that sends
+// each message straight from the pool (scatter-gather sendmsg(), optionally
+// MSG_ZEROCOPY), so N subscribers share one copy of the payload instead of
+// allocating N. A slot is reused only when no subscriber is still sending
+// from it (or, with MSG_ZEROCOPY, still waiting for its completion).
+#define POOL_SLOTS 64
+#define MAX_SUBSCRIBERS 1024
+#define DEFAULT_MAX_LAG 32
+
+typedef enum { SEND_IOVEC, SEND_ZEROCOPY } send_mode_t;
+// How a subscriber that falls max_lag messages behind is handled
+typedef enum {
+    LAG_BLOCK, // The producer waits for it (the slowest subscriber sets the pace)
+    LAG_DROP   // It skips ahead to the newest max_lag messages and counts the drops
+} lag_policy_t;
+
+send_mode_t send_mode = SEND_IOVEC;
+lag_policy_t lag_policy = LAG_BLOCK;
+long max_lag = DEFAULT_MAX_LAG;
+long publish_rate = 0; // Messages/s, 0 = as fast as the pool allows
+
+typedef struct {
+    MessageStruct msg;
+    long seq;   // Message currently held, -1 = never published
+    int refs;   // Sends (and zerocopy completions) still using this slot
+} PoolSlot;
+
+typedef struct {
+    int fd;
+    long cursor;                // Next sequence number to send
+    long zc_calls;              // Successful MSG_ZEROCOPY sendmsg() calls so far
+    long pend_zc[POOL_SLOTS];   // Last zerocopy call id of each unacknowledged message...
+    int pend_slot[POOL_SLOTS];  // ...and the slot it holds
+    int pend_head, pend_count;
+} Subscriber;
+
+pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+PoolSlot pool[POOL_SLOTS];
+size_t pool_msg_size = 0;   // Fixed by the first subscriber
+long head = 0;              // Next sequence number to publish
+Subscriber *subs[MAX_SUBSCRIBERS];
+int num_subs = 0;
+
+// Totals for the reporter (under pool_lock)
+long long total_published = 0;
+long long total_delivered = 0;
+long long total_dropped = 0;
+
+long read_rss_kb(void) {
+    char line[256];
+    long kb = 0;
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (!fp) return 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "VmRSS: %ld", &kb) == 1) break;
+    }
+    fclose(fp);
+    return kb;
+}
+
+// How far the producer is ahead of the subscriber it paces itself on: the
+// slowest one under LAG_BLOCK, the fastest one under LAG_DROP (so an
+// unpaced producer runs at the best subscriber's speed and only the
+// stragglers drop)
+long producer_lead(void) {
+    long lead = lag_policy == LAG_BLOCK ? 0 : max_lag;
+    for (int i = 0; i < num_subs; i++) {
+        long behind = head - subs[i]->cursor;
+        if (lag_policy == LAG_BLOCK ? behind > lead : behind < lead) lead = behind;
+    }
+    return lead;
+}
+
+void *producer_thread(void *arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    pthread_mutex_lock(&pool_lock);
+    while (1) {
+        PoolSlot *slot = &pool[head % POOL_SLOTS];
+        while (num_subs == 0 || slot->refs > 0 || producer_lead() >= max_lag) {
+            pthread_cond_wait(&pool_cond, &pool_lock);
+        }
+
+        // "Publish": stamp the sequence number into the recycled buffer
+        slot->seq = head;
+        memcpy(slot->msg.fields[0], &head, sizeof(head));
+        head++;
+        total_published++;
+        pthread_cond_broadcast(&pool_cond);
+
+        if (publish_rate > 0) {
+            pthread_mutex_unlock(&pool_lock);
+            next.tv_nsec += 1000000000L / publish_rate;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+            pthread_mutex_lock(&pool_lock);
+        }
+    }
+    return NULL;
+}
+
+// FANOUT,<mode>,<policy>,<subscribers>,<msg_size>,<published/s>,<delivered/s>,
+//        <fanout_gbps>,<dropped/s>,<pool_kb>,<rss_kb>
+void *reporter_thread(void *arg) {
+    (void)arg;
+    long long last_pub = 0, last_del = 0, last_drop = 0;
+    while (1) {
+        sleep(1);
+        pthread_mutex_lock(&pool_lock);
+        int n = num_subs;
+        long long pub = total_published - last_pub;
+        long long del = total_delivered - last_del;
+        long long drop = total_dropped - last_drop;
+        last_pub = total_published;
+        last_del = total_delivered;
+        last_drop = total_dropped;
+        size_t size = pool_msg_size;
+        pthread_mutex_unlock(&pool_lock);
+
+        if (n == 0 && del == 0) continue;
+        printf("FANOUT,%s,%s,%d,%zu,%lld,%lld,%.3f,%lld,%zu,%ld\n",
+               send_mode == SEND_ZEROCOPY ? "zerocopy" : "iovec",
+               lag_policy == LAG_DROP ? "drop" : "block", n, size, pub, del,
+               del * (double)size * 8.0 / 1e9, drop, POOL_SLOTS * size / 1024, read_rss_kb());
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+// Release the slots of every zerocopy send the kernel has finished with.
+// wait_ms > 0 blocks until a notification arrives (or the timeout).
+void reap_completions(Subscriber *sub, int wait_ms) {
+    if (sub->pend_count == 0) return;
+    if (wait_ms > 0) {
+        struct pollfd pfd = {sub->fd, 0, 0}; // POLLERR is always reported
+        poll(&pfd, 1, wait_ms);
+    }
+
+    long done = -1;
+    while (1) {
+        char control[128];
+        struct msghdr msg = {0};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sub->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if (serr->ee_errno == 0 && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY &&
+                (long)serr->ee_data > done) {
+                done = serr->ee_data; // Calls ee_info..ee_data have completed
+            }
+        }
+    }
+    if (done < 0) return;
+
+    pthread_mutex_lock(&pool_lock);
+    while (sub->pend_count > 0 && sub->pend_zc[sub->pend_head] <= done) {
+        pool[sub->pend_slot[sub->pend_head]].refs--;
+        sub->pend_head = (sub->pend_head + 1) % POOL_SLOTS;
+        sub->pend_count--;
+    }
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+}
+
+// Send one pooled message, advancing the iovec past partial sends
+int send_slot(Subscriber *sub, PoolSlot *slot) {
+    struct iovec iov[NUM_FIELDS];
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        iov[i].iov_base = slot->msg.fields[i];
+        iov[i].iov_len = slot->msg.field_sizes[i];
+    }
+    struct msghdr mh = {0};
+    mh.msg_iov = iov;
+    mh.msg_iovlen = NUM_FIELDS;
+    // One subscriber hanging up must not take the whole server down
+    int zc = send_mode == SEND_ZEROCOPY ? MSG_ZEROCOPY : 0;
+    int flags = MSG_NOSIGNAL | zc;
+
+    while (mh.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(sub->fd, &mh, flags);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS && zc) {
+                // Too many pinned pages outstanding: wait for completions
+                reap_completions(sub, 10);
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) return -1;
+        if (zc) sub->zc_calls++;
+
+        while (mh.msg_iovlen > 0 && (size_t)sent >= mh.msg_iov->iov_len) {
+            sent -= mh.msg_iov->iov_len;
+            mh.msg_iov++;
+            mh.msg_iovlen--;
+        }
+        if (mh.msg_iovlen > 0) {
+            mh.msg_iov->iov_base = (char *)mh.msg_iov->iov_base + sent;
+            mh.msg_iov->iov_len -= sent;
+        }
+    }
+    return 0;
+}
+
+// Allocate the pool for the first subscriber's size; later subscribers must match
+int pool_attach(size_t size) {
+    if (pool_msg_size == 0) {
+        for (int i = 0; i < POOL_SLOTS; i++) {
+            allocate_message(&pool[i].msg, size);
+            pool[i].seq = -1;
+            pool[i].refs = 0;
+        }
+        pool_msg_size = size;
+    }
+    return pool_msg_size == size ? 0 : -1;
+}
+
+void subscriber_remove(Subscriber *sub) {
+    for (int i = 0; i < num_subs; i++) {
+        if (subs[i] == sub) {
+            subs[i] = subs[--num_subs];
+            break;
+        }
+    }
+}
+
+void *handle_client(void *arg) {
+    int client_fd = *(int *)arg;
+    free(arg);
+
+    // 1. Receive message size from client
+    size_t total_payload_size;
+    ssize_t received = recv(client_fd, &total_payload_size, sizeof(total_payload_size), 0);
+    if (received != sizeof(total_payload_size)) {
+        perror("Failed to receive message size");
+        close(client_fd);
+        return NULL;
+    }
+
+    // Validate message size
+    if (total_payload_size < MIN_MSG_SIZE || total_payload_size > MAX_MSG_SIZE) {
+        fprintf(stderr, "Invalid message size received: %zu\n", total_payload_size);
+        close(client_fd);
+        return NULL;
+    }
+
+    if (send_mode == SEND_ZEROCOPY) {
+        int opt = 1;
+        if (setsockopt(client_fd, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) < 0) {
+            perror("setsockopt SO_ZEROCOPY failed (kernel might not support it)");
+            close(client_fd);
+            return NULL;
+        }
+    }
+    set_socket_options_tuned(client_fd, send_mode == SEND_ZEROCOPY ? "zero-copy" : "one-copy",
+                             total_payload_size);
+
+    // 2. Subscribe: share the pool instead of allocating a message
+    Subscriber *sub = calloc(1, sizeof(Subscriber));
+    if (!sub) {
+        perror("Malloc failed");
+        close(client_fd);
+        return NULL;
+    }
+    sub->fd = client_fd;
+
+    pthread_mutex_lock(&pool_lock);
+    if (pool_attach(total_payload_size) < 0 || num_subs == MAX_SUBSCRIBERS) {
+        pthread_mutex_unlock(&pool_lock);
+        fprintf(stderr, "Subscriber rejected: message size %zu (pool uses %zu) or too many subscribers\n",
+                total_payload_size, pool_msg_size);
+        free(sub);
+        close(client_fd);
+        return NULL;
+    }
+    sub->cursor = head; // New subscribers start at the next message
+    subs[num_subs++] = sub;
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+
+    while (1) {
+        // 3. Take a reference on the next message, dropping old ones if we lag
+        pthread_mutex_lock(&pool_lock);
+        while (sub->cursor >= head) {
+            if (sub->pend_count > 0) {
+                // Our own unacknowledged sends may be what the producer waits for
+                pthread_mutex_unlock(&pool_lock);
+                reap_completions(sub, 1);
+                pthread_mutex_lock(&pool_lock);
+                continue;
+            }
+            pthread_cond_wait(&pool_cond, &pool_lock);
+        }
+        if (lag_policy == LAG_DROP && head - sub->cursor > max_lag) {
+            total_dropped += head - max_lag - sub->cursor;
+            sub->cursor = head - max_lag;
+            pthread_cond_broadcast(&pool_cond);
+        }
+        int index = sub->cursor % POOL_SLOTS;
+        PoolSlot *slot = &pool[index];
+        slot->refs++;
+        pthread_mutex_unlock(&pool_lock);
+
+        // 4. Send it from the shared buffers
+        int failed = send_slot(sub, slot) < 0;
+
+        pthread_mutex_lock(&pool_lock);
+        sub->cursor++;
+        if (!failed) total_delivered++;
+        if (send_mode == SEND_ZEROCOPY && !failed) {
+            // Held until the kernel reports the pages are no longer in use
+            int tail = (sub->pend_head + sub->pend_count) % POOL_SLOTS;
+            sub->pend_zc[tail] = sub->zc_calls - 1;
+            sub->pend_slot[tail] = index;
+            sub->pend_count++;
+        } else {
+            slot->refs--;
+        }
+        pthread_cond_broadcast(&pool_cond);
+        pthread_mutex_unlock(&pool_lock);
+
+        if (failed) break; // Client closed or error
+
+        if (sub->pend_count == POOL_SLOTS) reap_completions(sub, 10);
+        else reap_completions(sub, 0);
+    }
+
+    // Give outstanding zerocopy sends a moment to complete, then let go
+    for (int i = 0; i < 100 && sub->pend_count > 0; i++) reap_completions(sub, 10);
+    pthread_mutex_lock(&pool_lock);
+    while (sub->pend_count > 0) {
+        pool[sub->pend_slot[sub->pend_head]].refs--;
+        sub->pend_head = (sub->pend_head + 1) % POOL_SLOTS;
+        sub->pend_count--;
+    }
+    subscriber_remove(sub);
+    pthread_cond_broadcast(&pool_cond);
+    pthread_mutex_unlock(&pool_lock);
+
+    close(client_fd);
+    free(sub);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int server_fd, *new_sock;
+    struct sockaddr_in address;
+    int addrlen = sizeof(address);
+
+    if (argc > 5) {
+        fprintf(stderr, "Usage: %s [iovec|zerocopy] [block|drop] [max_lag] [publish_rate]\n", argv[0]);
+        return -1;
+    }
+    if (argc > 1) {
+        if (strcmp(argv[1], "iovec") == 0) send_mode = SEND_IOVEC;
+        else if (strcmp(argv[1], "zerocopy") == 0) send_mode = SEND_ZEROCOPY;
+        else {
+            fprintf(stderr, "Unknown send mode: %s\n", argv[1]);
+            return -1;
+        }
+    }
+    if (argc > 2) {
+        if (strcmp(argv[2], "block") == 0) lag_policy = LAG_BLOCK;
+        else if (strcmp(argv[2], "drop") == 0) lag_policy = LAG_DROP;
+        else {
+            fprintf(stderr, "Unknown lag policy: %s\n", argv[2]);
+            return -1;
+        }
+    }
+    if (argc > 3) max_lag = atol(argv[3]);
+    if (argc > 4) publish_rate = atol(argv[4]);
+    // The lag window must fit in the pool so a lagging subscriber's next
+    // message is never the one being overwritten
+    if (max_lag < 1 || max_lag >= POOL_SLOTS || publish_rate < 0) {
+        fprintf(stderr, "max_lag must be between 1 and %d, publish_rate >= 0\n", POOL_SLOTS - 1);
+        return -1;
+    }
+
+    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+        perror("Socket failed");
+        exit(EXIT_FAILURE);
+    }
+
+    int opt = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt failed");
+        exit(EXIT_FAILURE);
+    }
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(PORT);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (listen(server_fd, 128) < 0) {
+        perror("Listen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
+    pthread_t producer, reporter;
+    if (pthread_create(&producer, NULL, producer_thread, NULL) != 0 ||
+        pthread_create(&reporter, NULL, reporter_thread, NULL) != 0) {
+        perror("Thread creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Server (A5 broadcast, %s, %s, max lag %ld) listening on port %d...\n",
+           send_mode == SEND_ZEROCOPY ? "zerocopy" : "iovec",
+           lag_policy == LAG_DROP ? "drop" : "block", max_lag, PORT);
+    fflush(stdout);
+
+    while (1) {
+        new_sock = malloc(sizeof(int));
+        if (!new_sock) {
+            perror("Malloc failed");
+            continue;
+        }
+
+        *new_sock = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen);
+        if (*new_sock < 0) {
+            perror("Accept failed");
+            free(new_sock);
+            continue;
+        }
+
+        pthread_t thread_id;
+        if (pthread_create(&thread_id, NULL, handle_client, (void *)new_sock) < 0) {
+            perror("Thread creation failed");
+            close(*new_sock);
+            free(new_sock);
+            continue;
+        }
+        pthread_detach(thread_id);
+    }
+
+    close(server_fd);
+    return 0;
+}
@@ -0,0 +1,491 @@
+// MT25088_PartA6_Server.c - Scheduled: backpressure-aware send scheduler with per-connection fairness
+#define _GNU_SOURCE
+#include "MT25088_Part_A_common.h"
+#include <sys/uio.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <linux/sockios.h>
+
+// The other servers run one thread per connection, each sending as fast as
+// it can, so the kernel's socket buffers decide who gets the bandwidth. Here
+// a single scheduler thread owns every connection (non-blocking, one-copy
+// sendmsg() as in A2) and decides itself:
+//  - Backpressure: TCP_NOTSENT_LOWAT bounds each socket's unsent bytes. A
+//    connection whose unsent queue (SIOCOUTQNSD) is at the mark is skipped
+//    until epoll reports it writable again, so data waits in the scheduler
+//    rather than in the kernel where it could no longer be reordered.
+//  - Fairness: deficit round robin. Each visit adds quantum * weight bytes
+//    of credit and the connection sends at most its credit. A connection
+//    that is backpressured keeps its unspent credit (up to DEFICIT_QUANTA
+//    visits' worth) rather than forfeiting it, as DRR forfeits credit only
+//    when a flow has nothing to send.
+//  - Rate limits: an optional token bucket per connection.
+// The two interact: if the mark is below quantum * weight, a heavy
+// connection hits it before spending its credit and every connection
+// effectively gets one mark's worth per round, whatever its weight. The
+// default mark is therefore sized to twice the largest credit.
+#define MAX_CONNS 1024
+#define MAX_WEIGHTS 16
+#define DEFAULT_QUANTUM (64 * 1024)
+#define DEFAULT_LOWAT (128 * 1024)  // Minimum; raised to 2 * quantum * max weight
+#define DEFICIT_QUANTA 4
+#define GREEDY_BUDGET (64 * 1024 * 1024)
+
+typedef enum {
+    SCHED_DRR,    // Deficit round robin over connections with room in the kernel
+    SCHED_GREEDY  // Same event loop, but fill each socket until EAGAIN (the baseline)
+} sched_t;
+
+sched_t sched_policy = SCHED_DRR;
+int weights[MAX_WEIGHTS] = {1};  // Cycled over connections in accept order
+int num_weights = 1;
+double rate_limit = 0.0;         // Bytes/s per connection (x weight), 0 = unlimited
+size_t quantum = DEFAULT_QUANTUM;
+int notsent_lowat = 0;           // 0 = size from quantum and weights
+
+typedef struct {
+    int fd;
+    int id;
+    int weight;
+    MessageStruct msg;
+    size_t msg_size;
+    size_t offset;        // Bytes of the current message already sent
+    size_t deficit;       // DRR credit in bytes
+    double tokens;        // Token bucket (bytes)
+    double burst;
+    double refilled;      // Time of the last refill
+    long long bytes;      // Sent in the current report interval
+} Conn;
+
+// New connections are handed over by the accept threads under conn_lock;
+// everything else belongs to the scheduler thread
+pthread_mutex_t conn_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t conn_cond = PTHREAD_COND_INITIALIZER;
+Conn *pending[MAX_CONNS];
+int num_pending = 0;
+int next_id = 0;
+
+Conn *conns[MAX_CONNS];
+int num_conns = 0;
+int epoll_fd;
+
+double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Ask for one EPOLLOUT once the socket can take data again. Arming runs the
+// socket's poll, which also sets the flag that makes TCP raise the wakeup
+// when the unsent queue drains below TCP_NOTSENT_LOWAT.
+void conn_arm(Conn *c) {
+    struct epoll_event ev = {0};
+    ev.events = EPOLLOUT | EPOLLONESHOT;
+    ev.data.ptr = c;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+void conn_close(Conn *c) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free_message(&c->msg);
+    free(c);
+}
+
+// Bytes written to the socket but not yet sent (SIOCOUTQNSD) or not yet
+// acknowledged (SIOCOUTQ)
+int queued_bytes(int fd, unsigned long req) {
+    int v = 0;
+    if (ioctl(fd, req, &v) < 0) return 0;
+    return v;
+}
+
+// Send up to budget bytes, continuing the current message from c->offset.
+// Returns the bytes sent, or -1 once the connection is gone. *blocked is set
+// when the socket stopped taking data.
+ssize_t conn_send(Conn *c, size_t budget, int *blocked) {
+    ssize_t total = 0;
+    *blocked = 0;
+
+    while ((size_t)total < budget) {
+        // Gather the rest of the message, starting inside a field if needed;
+        // a budget spanning several messages takes several calls
+        struct iovec iov[NUM_FIELDS];
+        int n = 0;
+        size_t skip = c->offset, room = budget - total;
+        for (int i = 0; i < NUM_FIELDS && room > 0; i++) {
+            if (skip >= c->msg.field_sizes[i]) {
+                skip -= c->msg.field_sizes[i];
+                continue;
+            }
+            size_t len = c->msg.field_sizes[i] - skip;
+            if (len > room) len = room;
+            iov[n].iov_base = c->msg.fields[i] + skip;
+            iov[n].iov_len = len;
+            room -= len;
+            skip = 0;
+            n++;
+        }
+        size_t want = budget - total - room;
+
+        struct msghdr mh = {0};
+        mh.msg_iov = iov;
+        mh.msg_iovlen = n;
+        ssize_t sent = sendmsg(c->fd, &mh, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                *blocked = 1;
+                break;
+            }
+            return -1;
+        }
+        if (sent == 0) return -1;
+
+        total += sent;
+        c->offset = (c->offset + sent) % c->msg_size;
+        if ((size_t)sent < want && sched_policy == SCHED_DRR) {
+            // Short write: the socket is full
+            *blocked = 1;
+            break;
+        }
+    }
+    c->bytes += total;
+    return total;
+}
+
+// Pull in connections accepted since the last round; wait if there are none
+void adopt_pending(void) {
+    pthread_mutex_lock(&conn_lock);
+    while (num_conns == 0 && num_pending == 0) {
+        pthread_cond_wait(&conn_cond, &conn_lock);
+    }
+    for (int i = 0; i < num_pending; i++) {
+        if (num_conns == MAX_CONNS) {
+            conn_close(pending[i]);
+            continue;
+        }
+        conns[num_conns++] = pending[i];
+    }
+    num_pending = 0;
+    pthread_mutex_unlock(&conn_lock);
+}
+
+// Per connection:  SCHED_CONN,<id>,<weight>,<mbps>,<queued_bytes>,<unsent_bytes>
+// Aggregate:       SCHED,<policy>,<conns>,<total_gbps>,<jain>,<min_mbps>,<max_mbps>
+// Jain's index is taken over throughput / weight, so 1.0 means every
+// connection got exactly its weighted share.
+void report(double interval) {
+    double sum = 0.0, sum_sq = 0.0, total = 0.0, min = 0.0, max = 0.0;
+
+    for (int i = 0; i < num_conns; i++) {
+        Conn *c = conns[i];
+        double mbps = c->bytes * 8.0 / interval / 1e6;
+        double share = mbps / c->weight;
+        printf("SCHED_CONN,%d,%d,%.2f,%d,%d\n", c->id, c->weight, mbps,
+               queued_bytes(c->fd, SIOCOUTQ), queued_bytes(c->fd, SIOCOUTQNSD));
+        sum += share;
+        sum_sq += share * share;
+        total += mbps;
+        if (i == 0 || mbps < min) min = mbps;
+        if (i == 0 || mbps > max) max = mbps;
+        c->bytes = 0;
+    }
+    double jain = sum_sq > 0.0 ? sum * sum / (num_conns * sum_sq) : 0.0;
+    printf("SCHED,%s,%d,%.3f,%.4f,%.2f,%.2f\n", sched_policy == SCHED_DRR ? "drr" : "greedy",
+           num_conns, total / 1000.0, jain, min, max);
+    fflush(stdout);
+}
+
+void *scheduler_thread(void *arg) {
+    (void)arg;
+    struct epoll_event events[64];
+    int rr = 0;  // Where the next round starts, so no connection is always first
+    double last_report = now_sec();
+
+    while (1) {
+        adopt_pending();
+
+        int progress = 0, sock_blocked = 0;
+        double token_wait = -1.0;  // Seconds until the first rate-limited connection may send
+        double now = now_sec();
+
+        for (int k = 0; k < num_conns; k++) {
+            int i = (rr + k) % num_conns;
+            Conn *c = conns[i];
+
+            size_t budget = GREEDY_BUDGET;
+            if (sched_policy == SCHED_DRR) {
+                // Backpressure: only top up sockets that are below the mark
+                // (a blocked connection keeps its credit)
+                if (queued_bytes(c->fd, SIOCOUTQNSD) >= notsent_lowat) {
+                    conn_arm(c);
+                    sock_blocked++;
+                    continue;
+                }
+                c->deficit += quantum * c->weight;
+                if (c->deficit > DEFICIT_QUANTA * quantum * c->weight) {
+                    c->deficit = DEFICIT_QUANTA * quantum * c->weight;
+                }
+                budget = c->deficit;
+            }
+
+            if (rate_limit > 0.0) {
+                double rate = rate_limit * c->weight;
+                c->tokens += (now - c->refilled) * rate;
+                if (c->tokens > c->burst) c->tokens = c->burst;
+                c->refilled = now;
+                if (c->tokens < quantum) {
+                    double wait = (quantum - c->tokens) / rate;
+                    if (token_wait < 0.0 || wait < token_wait) token_wait = wait;
+                    continue;
+                }
+                if (budget > c->tokens) budget = (size_t)c->tokens;
+            }
+
+            int blocked;
+            ssize_t sent = conn_send(c, budget, &blocked);
+            if (sent < 0) {
+                // Client closed or error; removed after the round so the
+                // visiting order of the others does not change mid-round
+                conn_close(c);
+                conns[i] = NULL;
+                continue;
+            }
+            if (sent > 0) progress = 1;
+            if (rate_limit > 0.0) c->tokens -= sent;
+            if (sched_policy == SCHED_DRR) c->deficit -= sent;
+            if (blocked) {
+                conn_arm(c);
+                sock_blocked++;
+            }
+        }
+
+        // Drop the closed connections, keeping the order of the rest, and
+        // start the next round one connection later
+        int kept = 0, next_rr = 0;
+        for (int i = 0; i < num_conns; i++) {
+            if (i == rr + 1) next_rr = kept;
+            if (conns[i]) conns[kept++] = conns[i];
+        }
+        num_conns = kept;
+        rr = num_conns > 0 ? next_rr % num_conns : 0;
+
+        now = now_sec();
+        if (now - last_report >= 1.0) {
+            report(now - last_report);
+            last_report = now;
+        }
+
+        if (progress || num_conns == 0) continue;
+
+        // Nothing could send: sleep until a blocked socket drains below the
+        // mark or a token bucket refills
+        int timeout_ms = 100;
+        if (token_wait >= 0.0) timeout_ms = (int)(token_wait * 1000.0) + 1;
+        if (sock_blocked > 0) {
+            epoll_wait(epoll_fd, events, 64, timeout_ms);
+        } else {
+            usleep((useconds_t)(token_wait * 1e6) + 1);
+        }
+    }
+    return NULL;
+}
+
+void *handle_client(void *arg) {
+    int client_fd = *(int *)arg;
+    free(arg);
+
+    // 1. Receive message size from client
+    size_t total_payload_size;
+    ssize_t received = recv(client_fd, &total_payload_size, sizeof(total_payload_size), 0);
+    if (received != sizeof(total_payload_size)) {
+        perror("Failed to receive message size");
+        close(client_fd);
+        return NULL;
+    }
+
+    // Validate message size
+    if (total_payload_size < MIN_MSG_SIZE || total_payload_size > MAX_MSG_SIZE) {
+        fprintf(stderr, "Invalid message size received: %zu\n", total_payload_size);
+        close(client_fd);
+        return NULL;
+    }
+
+    // 2. Setup Data (Same as A2)
+    Conn *c = calloc(1, sizeof(Conn));
+    if (!c) {
+        perror("Malloc failed");
+        close(client_fd);
+        return NULL;
+    }
+    allocate_message(&c->msg, total_payload_size);
+    c->fd = client_fd;
+    c->msg_size = c->msg.field_sizes[0] * NUM_FIELDS;
+
+    // Set socket options; the scheduler's mark overrides the profile's
+    set_socket_options_tuned(client_fd, "one-copy", total_payload_size);
+    if (sched_policy == SCHED_DRR &&
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &notsent_lowat,
+                   sizeof(notsent_lowat)) < 0) {
+        perror("Warning: TCP_NOTSENT_LOWAT failed");
+    }
+    fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+
+    // 3. Hand the connection to the scheduler; this thread is done
+    pthread_mutex_lock(&conn_lock);
+    if (num_pending == MAX_CONNS) {
+        pthread_mutex_unlock(&conn_lock);
+        fprintf(stderr, "Connection rejected: too many connections\n");
+        free_message(&c->msg);
+        free(c);
+        close(client_fd);
+        return NULL;
+    }
+    c->id = next_id++;
+    c->weight = weights[c->id % num_weights];
+    // Room for two quanta or 10 ms of traffic, so tokens that accrue while
+    // the scheduler oversleeps are not thrown away
+    c->burst = 2.0 * quantum * c->weight;
+    if (c->burst < rate_limit * c->weight / 100.0) c->burst = rate_limit * c->weight / 100.0;
+    c->tokens = c->burst;
+    c->refilled = now_sec();
+
+    struct epoll_event ev = {0};
+    ev.events = EPOLLONESHOT;  // Armed by conn_arm() when it blocks
+    ev.data.ptr = c;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &ev);
+
+    pending[num_pending++] = c;
+    pthread_cond_signal(&conn_cond);
+    pthread_mutex_unlock(&conn_lock);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int server_fd, *new_sock;
+    struct sockaddr_in address;
+    int addrlen = sizeof(address);
+
+    if (argc > 6) {
+        fprintf(stderr, "Usage: %s [drr|greedy] [weights e.g. 1,2,4] [rate_mbps] [quantum] [notsent_lowat]\n",
+                argv[0]);
+        return -1;
+    }
+    if (argc > 1) {
+        if (strcmp(argv[1], "drr") == 0) sched_policy = SCHED_DRR;
+        else if (strcmp(argv[1], "greedy") == 0) sched_policy = SCHED_GREEDY;
+        else {
+            fprintf(stderr, "Unknown scheduler: %s\n", argv[1]);
+            return -1;
+        }
+    }
+    if (argc > 2) {
+        char buf[256];
+        num_weights = 0;
+        snprintf(buf, sizeof(buf), "%s", argv[2]);
+        for (char *tok = strtok(buf, ","); tok && num_weights < MAX_WEIGHTS; tok = strtok(NULL, ",")) {
+            weights[num_weights] = atoi(tok);
+            if (weights[num_weights] < 1) {
+                fprintf(stderr, "Unknown weight: %s\n", tok);
+                return -1;
+            }
+            num_weights++;
+        }
+        if (num_weights == 0) {
+            fprintf(stderr, "Unknown weights: %s\n", argv[2]);
+            return -1;
+        }
+    }
+    if (argc > 3) rate_limit = atof(argv[3]) * 1e6 / 8.0;
+    if (argc > 4) quantum = (size_t)atol(argv[4]);
+    if (argc > 5) notsent_lowat = atoi(argv[5]);
+    if (rate_limit < 0.0 || quantum < 1024 || (argc > 5 && notsent_lowat < 1)) {
+        fprintf(stderr, "rate_mbps must be >= 0, quantum >= 1024, notsent_lowat >= 1\n");
+        return -1;
+    }
+    // Default mark: room for the largest credit on top of a half-drained queue
+    int max_weight = 1;
+    for (int i = 0; i < num_weights; i++) {
+        if (weights[i] > max_weight) max_weight = weights[i];
+    }
+    if (notsent_lowat == 0) {
+        size_t lowat = 2 * quantum * max_weight;
+        notsent_lowat = lowat > DEFAULT_LOWAT ? (int)lowat : DEFAULT_LOWAT;
+    } else if ((size_t)notsent_lowat < quantum * max_weight) {
+        fprintf(stderr, "Warning: notsent_lowat %d < quantum * max weight (%zu), weights will not hold\n",
+                notsent_lowat, quantum * max_weight);
+    }
+
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+        perror("Socket failed");
+        exit(EXIT_FAILURE);
+    }
+
+    int opt = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt failed");
+        exit(EXIT_FAILURE);
+    }
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(PORT);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (listen(server_fd, 128) < 0) {
+        perror("Listen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Per-size buffer tuning produced by the Part E tuner (optional)
+    load_socket_profile();
+
+    pthread_t scheduler;
+    if (pthread_create(&scheduler, NULL, scheduler_thread, NULL) != 0) {
+        perror("Thread creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Server (A6 scheduled, %s, quantum %zu, notsent lowat %d) listening on port %d...\n",
+           sched_policy == SCHED_DRR ? "drr" : "greedy", quantum, notsent_lowat, PORT);
+    fflush(stdout);
+
+    while (1) {
+        new_sock = malloc(sizeof(int));
+        if (!new_sock) {
+            perror("Malloc failed");
+            continue;
+        }
+
+        *new_sock = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen);
+        if (*new_sock < 0) {
+            perror("Accept failed");
+            free(new_sock);
+            continue;
+        }
+
+        pthread_t thread_id;
+        if (pthread_create(&thread_id, NULL, handle_client, (void *)new_sock) < 0) {
+            perror("Thread creation failed");
+            close(*new_sock);
+            free(new_sock);
+            continue;
+        }
+        pthread_detach(thread_id);
+    }
+
+    close(server_fd);
+    return 0;
+}
@@ -77,4 +77,109 @@ void set_socket_options(int sock) {
     }
 }
 
+// --- Socket tuning profile (written by the Part E tuner) ---
+// One line per (strategy, message size):
+//   <strategy> <msg_size> <sndbuf> <rcvbuf> <notsent_lowat> <nodelay> [gbps]
+// A buffer size of 0 leaves the kernel's autotuning in charge, and a
+// notsent_lowat of 0 leaves TCP_NOTSENT_LOWAT unset.
+#ifndef TCP_NOTSENT_LOWAT
+#define TCP_NOTSENT_LOWAT 25
+#endif
+
+#define SOCK_PROFILE_ENV "MT25088_SOCK_PROFILE"
+#define SOCK_PROFILE_DEFAULT "MT25088_socket_profile.txt"
+#define MAX_PROFILE_ENTRIES 128
+
+typedef struct {
+    char strategy[16];
+    size_t msg_size;
+    int sndbuf;
+    int rcvbuf;
+    int notsent_lowat;
+    int nodelay;
+} SocketProfileEntry;
+
+SocketProfileEntry sock_profile[MAX_PROFILE_ENTRIES];
+int sock_profile_count = 0;
+
+// Load the profile named by $MT25088_SOCK_PROFILE (or the default file in
+// the working directory). Call once from main() before any threads start.
+// Returns the number of entries loaded; 0 means the hard-coded defaults apply.
+int load_socket_profile(void) {
+    const char *path = getenv(SOCK_PROFILE_ENV);
+    if (!path) path = SOCK_PROFILE_DEFAULT;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    char line[256];
+    sock_profile_count = 0;
+    while (fgets(line, sizeof(line), fp) && sock_profile_count < MAX_PROFILE_ENTRIES) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        SocketProfileEntry *e = &sock_profile[sock_profile_count];
+        if (sscanf(line, "%15s %zu %d %d %d %d", e->strategy, &e->msg_size,
+                   &e->sndbuf, &e->rcvbuf, &e->notsent_lowat, &e->nodelay) == 6) {
+            sock_profile_count++;
+        }
+    }
+    fclose(fp);
+
+    fprintf(stderr, "Loaded %d socket profile entries from %s\n", sock_profile_count, path);
+    return sock_profile_count;
+}
+
+// Find the entry for this strategy whose message size is closest (on a log
+// scale) to msg_size. A strategy of "*" matches any entry.
+const SocketProfileEntry *find_socket_profile(const char *strategy, size_t msg_size) {
+    const SocketProfileEntry *best = NULL;
+    double best_dist = 0.0;
+
+    for (int i = 0; i < sock_profile_count; i++) {
+        const SocketProfileEntry *e = &sock_profile[i];
+        if (strcmp(strategy, "*") != 0 && strcmp(strategy, e->strategy) != 0) continue;
+
+        double ratio = (double)e->msg_size / (double)msg_size;
+        double dist = ratio > 1.0 ? ratio : 1.0 / ratio;
+        if (!best || dist < best_dist) {
+            best = e;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+// Apply a single profile entry to a socket
+void apply_socket_profile(int sock, const SocketProfileEntry *e) {
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &e->nodelay, sizeof(e->nodelay)) < 0) {
+        perror("Warning: TCP_NODELAY failed");
+    }
+    // Setting SO_SNDBUF/SO_RCVBUF pins the size and disables autotuning,
+    // so only touch them when the profile asks for a fixed size
+    if (e->sndbuf > 0 &&
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &e->sndbuf, sizeof(e->sndbuf)) < 0) {
+        perror("Warning: SO_SNDBUF failed");
+    }
+    if (e->rcvbuf > 0 &&
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &e->rcvbuf, sizeof(e->rcvbuf)) < 0) {
+        perror("Warning: SO_RCVBUF failed");
+    }
+    if (e->notsent_lowat > 0 &&
+        setsockopt(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &e->notsent_lowat,
+                   sizeof(e->notsent_lowat)) < 0) {
+        perror("Warning: TCP_NOTSENT_LOWAT failed");
+    }
+}
+
+// Set socket options from the loaded profile, falling back to the fixed
+// defaults of set_socket_options() when no profile entry matches
+void set_socket_options_tuned(int sock, const char *strategy, size_t msg_size) {
+    const SocketProfileEntry *e = find_socket_profile(strategy, msg_size);
+    if (e) {
+        apply_socket_profile(sock, e);
+    } else {
+        set_socket_options(sock);
+    }
+}
+
 #endif
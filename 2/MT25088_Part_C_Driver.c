@@ -0,0 +1,551 @@
+// MT25088_Part_C_Driver.c
+// Native benchmark driver: repeated, randomized trials with confidence intervals.
+//
+// For every (implementation, threads, message size) cell this runs N trials
+// in a randomized global order. Each trial starts its own server, waits until
+// the port is actually listening, runs the client, and stops the server with
+// SIGTERM/waitpid (no fuser). Results are written as:
+//   <prefix>_trials.csv   one row per trial (raw data)
+//   <prefix>_summary.csv  mean, stddev and 95% CI per cell
+//   <prefix>.json         both of the above
+//   <prefix>_fanout.csv   the Broadcast server's own FANOUT report per trial
+//   <prefix>_sched.csv    the Scheduled server's own SCHED report per trial
+#include "MT25088_Part_A_common.h"
+#include <math.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+typedef struct {
+    const char *name;      // Implementation label used in the CSVs
+    const char *server;    // Server binary
+    const char *strategy;  // Socket profile strategy passed to the client
+    const char *args[2];   // Optional server arguments (NULL-terminated)
+} impl_t;
+
+impl_t IMPLS[] = {
+    {"Two-Copy", "./server_a1", "two-copy", {NULL, NULL}},
+    {"One-Copy", "./server_a2", "one-copy", {NULL, NULL}},
+    {"Zero-Copy", "./server_a3", "zero-copy", {NULL, NULL}},
+    {"Sendfile", "./server_a4", "one-copy", {"memfd", "sendfile"}},
+    {"Splice", "./server_a4", "one-copy", {"memfd", "splice"}},
+    {"Sendfile-Cold", "./server_a4", "one-copy", {"disk-cold", "sendfile"}},
+    {"Broadcast", "./server_a5", "one-copy", {"iovec", "block"}},
+    {"Scheduled", "./server_a6", "one-copy", {"drr", NULL}},
+};
+#define NUM_IMPLS ((int)(sizeof(IMPLS) / sizeof(IMPLS[0])))
+
+#define MAX_LIST 16
+
+// One FANOUT report of the Broadcast server (A5), per second of the run
+typedef struct {
+    int subscribers;
+    long long published;    // Messages per second
+    long long delivered;
+    double gbps;            // Fan-out bandwidth
+    long long dropped;
+    long pool_kb;
+    long rss_kb;
+} fanout_t;
+
+// One SCHED report of the Scheduled server (A6), per second of the run
+typedef struct {
+    char policy[16];
+    int conns;
+    double gbps;            // All connections together
+    double jain;            // Jain's index over throughput / weight
+    double min_mbps;
+    double max_mbps;
+} sched_report_t;
+
+typedef struct {
+    int impl;
+    int threads;
+    int msg_size;
+    int rep;
+    int ok;
+    double gbps;
+    double latency_us;
+    int has_fanout;
+    fanout_t fanout;
+    int has_sched;
+    sched_report_t sched;
+} trial_t;
+
+// 95% two-sided Student t critical values for df = 1..30
+double T_CRIT[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+// Beyond 30: tabulated points, with df = 0 standing for infinity (1.960)
+int T_CRIT_DF[] = {30, 40, 60, 120, 0};
+double T_CRIT_TAIL[] = {2.042, 2.021, 2.000, 1.980, 1.960};
+
+// Between tabulated points, interpolate linearly in 1/df (the standard
+// table interpolation, accurate to about 0.001 here)
+double t_critical(int df) {
+    if (df < 1) return 0.0;
+    if (df <= 30) return T_CRIT[df - 1];
+    for (int i = 1; i < (int)(sizeof(T_CRIT_DF) / sizeof(T_CRIT_DF[0])); i++) {
+        if (T_CRIT_DF[i] != 0 && df > T_CRIT_DF[i]) continue;
+        double x0 = 1.0 / T_CRIT_DF[i - 1];
+        double x1 = T_CRIT_DF[i] ? 1.0 / T_CRIT_DF[i] : 0.0;
+        double f = (x0 - 1.0 / df) / (x0 - x1);
+        return T_CRIT_TAIL[i - 1] + f * (T_CRIT_TAIL[i] - T_CRIT_TAIL[i - 1]);
+    }
+    return 1.960;
+}
+
+double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Every name in a comma-separated -i list must be an entry of IMPLS
+int valid_impl_list(const char *list) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        int known = 0;
+        for (int i = 0; i < NUM_IMPLS && !known; i++) known = strcmp(tok, IMPLS[i].name) == 0;
+        if (!known) {
+            fprintf(stderr, "Unknown implementation: %s\n", tok);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int parse_list(const char *arg, int *out) {
+    char buf[256];
+    int n = 0;
+    snprintf(buf, sizeof(buf), "%s", arg);
+    for (char *tok = strtok(buf, ","); tok && n < MAX_LIST; tok = strtok(NULL, ",")) {
+        out[n++] = atoi(tok);
+    }
+    return n;
+}
+
+// Exact match of name in a comma-separated list ("Sendfile" must not
+// also select "Sendfile-Cold")
+int in_list(const char *list, const char *name) {
+    size_t len = strlen(name);
+    for (const char *p = list; (p = strstr(p, name)) != NULL; p += len) {
+        int starts = (p == list || p[-1] == ',');
+        int ends = (p[len] == '\0' || p[len] == ',');
+        if (starts && ends) return 1;
+    }
+    return 0;
+}
+
+// True once something is listening on the TCP port (checked via /proc so
+// the probe itself does not open a connection to the server)
+int port_listening(int port) {
+    const char *files[] = {"/proc/net/tcp", "/proc/net/tcp6"};
+    char line[512];
+
+    for (int f = 0; f < 2; f++) {
+        FILE *fp = fopen(files[f], "r");
+        if (!fp) continue;
+        while (fgets(line, sizeof(line), fp)) {
+            char local[128];
+            unsigned int state;
+            if (sscanf(line, " %*d: %127s %*s %x", local, &state) != 2) continue;
+            char *colon = strrchr(local, ':');
+            if (colon && (int)strtol(colon + 1, NULL, 16) == port && state == 0x0A) {
+                fclose(fp);
+                return 1;
+            }
+        }
+        fclose(fp);
+    }
+    return 0;
+}
+
+// Kill a child and reap it; escalate to SIGKILL if it ignores SIGTERM
+void stop_child(pid_t pid) {
+    if (pid <= 0) return;
+    kill(pid, SIGTERM);
+    for (int i = 0; i < 100; i++) {
+        if (waitpid(pid, NULL, WNOHANG) == pid) return;
+        usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+pid_t start_server(const impl_t *impl, int log_fd) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(log_fd, STDOUT_FILENO);
+        dup2(log_fd, STDERR_FILENO);
+        execl(impl->server, impl->server, impl->args[0], impl->args[1], (char *)NULL);
+        perror("exec server failed");
+        _exit(127);
+    }
+    return pid;
+}
+
+// Start the server and wait until its port is listening. Returns the PID,
+// or -1 if the server exited or never came up.
+pid_t supervise_server_start(const impl_t *impl, int log_fd) {
+    // A previous server may still be holding the port for a moment
+    for (int i = 0; i < 200 && port_listening(PORT); i++) usleep(10000);
+
+    pid_t pid = start_server(impl, log_fd);
+    if (pid < 0) return -1;
+
+    for (int i = 0; i < 500; i++) {
+        if (waitpid(pid, NULL, WNOHANG) == pid) return -1; // Server died
+        if (port_listening(PORT)) return pid;
+        usleep(10000);
+    }
+    stop_child(pid);
+    return -1;
+}
+
+// Run the client and parse its DATA line. Returns 1 on success.
+int run_client(const char *client, const impl_t *impl, int threads, int msg_size,
+               int duration, double *gbps, double *latency_us) {
+    int out[2];
+    if (pipe(out) < 0) return 0;
+
+    char threads_arg[16], size_arg[16], dur_arg[16];
+    snprintf(threads_arg, sizeof(threads_arg), "%d", threads);
+    snprintf(size_arg, sizeof(size_arg), "%d", msg_size);
+    snprintf(dur_arg, sizeof(dur_arg), "%d", duration);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(out[0]);
+        dup2(out[1], STDOUT_FILENO);
+        execl(client, client, "127.0.0.1", threads_arg, size_arg, dur_arg,
+              impl->strategy, (char *)NULL);
+        perror("exec client failed");
+        _exit(127);
+    }
+    close(out[1]);
+    if (pid < 0) {
+        close(out[0]);
+        return 0;
+    }
+
+    // Read output until EOF, but never wait much longer than the run itself
+    char buf[4096];
+    size_t len = 0;
+    double deadline = now_sec() + duration + 10.0;
+    fcntl(out[0], F_SETFL, O_NONBLOCK);
+    while (now_sec() < deadline) {
+        ssize_t n = read(out[0], buf + len, sizeof(buf) - 1 - len);
+        if (n == 0) break;
+        if (n > 0) {
+            len += n;
+            if (len >= sizeof(buf) - 1) break;
+        } else {
+            usleep(10000);
+        }
+    }
+    buf[len] = '\0';
+    close(out[0]);
+
+    // EOF normally means the client is exiting; give it a moment to be reaped
+    int status = 0, reaped = 0;
+    for (int i = 0; i < 200 && !reaped; i++) {
+        reaped = waitpid(pid, &status, WNOHANG) == pid;
+        if (!reaped) usleep(10000);
+    }
+    if (!reaped) {
+        stop_child(pid);
+        return 0;
+    }
+
+    char *line = strstr(buf, "DATA,");
+    long long bytes, messages;
+    double mbps, lat;
+    if (!line || sscanf(line, "DATA,%lld,%lld,%lf,%lf", &bytes, &messages, &mbps, &lat) != 4) {
+        return 0;
+    }
+    *gbps = mbps / 1000.0;
+    *latency_us = lat;
+    return 1;
+}
+
+// The server's output during one trial: bytes [from, to) of the server log
+char *read_log_slice(const char *path, off_t from, off_t to) {
+    if (to <= from) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    char *buf = malloc(to - from + 1);
+    ssize_t n = buf ? pread(fd, buf, to - from, from) : -1;
+    close(fd);
+    if (n < 0) {
+        free(buf);
+        return NULL;
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+// FANOUT,<mode>,<policy>,<subscribers>,<msg_size>,<published/s>,<delivered/s>,
+//        <fanout_gbps>,<dropped/s>,<pool_kb>,<rss_kb>
+// Keeps the last report with subscribers still connected; a report after
+// that only covers the client hanging up.
+void parse_fanout(const char *out, trial_t *t) {
+    for (const char *p = out; (p = strstr(p, "FANOUT,")) != NULL; p++) {
+        if (p != out && p[-1] != '\n') continue;
+        fanout_t f;
+        if (sscanf(p, "FANOUT,%*[^,],%*[^,],%d,%*[^,],%lld,%lld,%lf,%lld,%ld,%ld",
+                   &f.subscribers, &f.published, &f.delivered, &f.gbps, &f.dropped,
+                   &f.pool_kb, &f.rss_kb) == 7 && f.subscribers > 0) {
+            t->fanout = f;
+            t->has_fanout = 1;
+        }
+    }
+}
+
+// SCHED,<policy>,<conns>,<total_gbps>,<jain>,<min_mbps>,<max_mbps>
+// Keeps the last report with connections still open, as for FANOUT
+void parse_sched(const char *out, trial_t *t) {
+    for (const char *p = out; (p = strstr(p, "SCHED,")) != NULL; p++) {
+        if (p != out && p[-1] != '\n') continue;
+        sched_report_t r;
+        if (sscanf(p, "SCHED,%15[^,],%d,%lf,%lf,%lf,%lf", r.policy, &r.conns, &r.gbps, &r.jain,
+                   &r.min_mbps, &r.max_mbps) == 6 && r.conns > 0) {
+            t->sched = r;
+            t->has_sched = 1;
+        }
+    }
+}
+
+void summarize(const trial_t *trials, int n, int impl, int threads, int msg_size,
+               int metric, int *count, double *mean, double *sd, double *ci) {
+    double sum = 0.0, sumsq = 0.0;
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        const trial_t *t = &trials[i];
+        if (!t->ok || t->impl != impl || t->threads != threads || t->msg_size != msg_size) continue;
+        double v = metric == 0 ? t->gbps : t->latency_us;
+        sum += v;
+        sumsq += v * v;
+        k++;
+    }
+    *count = k;
+    *mean = k ? sum / k : 0.0;
+    double var = k > 1 ? (sumsq - k * (*mean) * (*mean)) / (k - 1) : 0.0;
+    *sd = var > 0 ? sqrt(var) : 0.0;
+    *ci = k > 1 ? t_critical(k - 1) * (*sd) / sqrt(k) : 0.0;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-r reps] [-d seconds] [-t 1,2,4,8] [-s 4096,65536]\n"
+                    "       [-i Two-Copy,One-Copy,Zero-Copy,Sendfile,Splice,Sendfile-Cold,Broadcast,Scheduled]\n"
+                    "       [-o prefix] [-S seed] [-c client]\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    int threads[MAX_LIST] = {1, 2, 4, 8}, num_threads = 4;
+    int sizes[MAX_LIST] = {4096, 16384, 65536, 524288}, num_sizes = 4;
+    int use_impl[NUM_IMPLS];
+    int reps = 5;
+    int duration = 5;
+    unsigned int seed = (unsigned int)time(NULL);
+    const char *prefix = "driver_results";
+    const char *client = "./client_b";
+    for (int i = 0; i < NUM_IMPLS; i++) use_impl[i] = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:d:t:s:i:o:S:c:h")) != -1) {
+        switch (opt) {
+        case 'r': reps = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 't': num_threads = parse_list(optarg, threads); break;
+        case 's': num_sizes = parse_list(optarg, sizes); break;
+        case 'i':
+            if (!valid_impl_list(optarg)) {
+                usage(argv[0]);
+                return -1;
+            }
+            for (int i = 0; i < NUM_IMPLS; i++) use_impl[i] = in_list(optarg, IMPLS[i].name);
+            break;
+        case 'o': prefix = optarg; break;
+        case 'S': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+        case 'c': client = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (reps < 1 || duration < 1 || num_threads < 1 || num_sizes < 1) {
+        fprintf(stderr, "Invalid repetition count, duration or list\n");
+        return -1;
+    }
+
+    // Build the full trial list, then shuffle it (Fisher-Yates) so slow drift
+    // in machine state does not line up with any one cell
+    int max_trials = NUM_IMPLS * num_threads * num_sizes * reps;
+    trial_t *trials = calloc(max_trials, sizeof(trial_t));
+    if (!trials) {
+        perror("Memory allocation failed");
+        return -1;
+    }
+    int n = 0;
+    for (int i = 0; i < NUM_IMPLS; i++) {
+        if (!use_impl[i]) continue;
+        for (int t = 0; t < num_threads; t++)
+            for (int s = 0; s < num_sizes; s++)
+                for (int r = 0; r < reps; r++) {
+                    trials[n].impl = i;
+                    trials[n].threads = threads[t];
+                    trials[n].msg_size = sizes[s];
+                    trials[n].rep = r;
+                    n++;
+                }
+    }
+    srand(seed);
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        trial_t tmp = trials[i];
+        trials[i] = trials[j];
+        trials[j] = tmp;
+    }
+
+    char path[512], log_path[512];
+    snprintf(log_path, sizeof(log_path), "%s_server.log", prefix);
+    int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log_fd < 0) {
+        perror("Cannot open server log");
+        return -1;
+    }
+
+    printf("Running %d trials (seed %u, %d s each)\n", n, seed, duration);
+    for (int i = 0; i < n; i++) {
+        trial_t *t = &trials[i];
+        const impl_t *impl = &IMPLS[t->impl];
+        off_t log_start = lseek(log_fd, 0, SEEK_CUR);
+
+        pid_t server = supervise_server_start(impl, log_fd);
+        if (server < 0) {
+            fprintf(stderr, "[%d/%d] %s: server failed to start\n", i + 1, n, impl->name);
+            continue;
+        }
+
+        t->ok = run_client(client, impl, t->threads, t->msg_size, duration,
+                           &t->gbps, &t->latency_us);
+
+        // A server that died during the run invalidates the trial. The servers
+        // do not ignore SIGPIPE, so dying from it once the client has hung up
+        // is the normal end of a run.
+        int status;
+        if (waitpid(server, &status, WNOHANG) == server) {
+            if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGPIPE) t->ok = 0;
+        } else {
+            stop_child(server);
+        }
+
+        // The server shares log_fd's offset, so it now ends this trial's output
+        char *out = t->ok ? read_log_slice(log_path, log_start, lseek(log_fd, 0, SEEK_CUR)) : NULL;
+        if (out) {
+            parse_fanout(out, t);
+            parse_sched(out, t);
+            free(out);
+        }
+
+        printf("[%d/%d] %-9s T=%-2d S=%-7d rep=%d -> %s %.2f Gbps %.2f us\n", i + 1, n,
+               impl->name, t->threads, t->msg_size, t->rep, t->ok ? "ok" : "FAILED",
+               t->gbps, t->latency_us);
+        fflush(stdout);
+    }
+    close(log_fd);
+
+    // Raw per-trial data (in execution order)
+    snprintf(path, sizeof(path), "%s_trials.csv", prefix);
+    FILE *raw = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s_summary.csv", prefix);
+    FILE *sum = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.json", prefix);
+    FILE *json = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s_fanout.csv", prefix);
+    FILE *fan = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s_sched.csv", prefix);
+    FILE *sched = fopen(path, "w");
+    if (!raw || !sum || !json || !fan || !sched) {
+        perror("Cannot open output files");
+        return -1;
+    }
+
+    fprintf(raw, "Order,Implementation,Threads,MsgSize,Rep,Ok,Throughput_Gbps,Latency_us\n");
+    fprintf(json, "{\n  \"seed\": %u,\n  \"duration_s\": %d,\n  \"reps\": %d,\n  \"trials\": [\n",
+            seed, duration, reps);
+    for (int i = 0; i < n; i++) {
+        const trial_t *t = &trials[i];
+        fprintf(raw, "%d,%s,%d,%d,%d,%d,%.4f,%.4f\n", i, IMPLS[t->impl].name, t->threads,
+                t->msg_size, t->rep, t->ok, t->gbps, t->latency_us);
+        fprintf(json, "    {\"order\": %d, \"impl\": \"%s\", \"threads\": %d, \"msg_size\": %d, "
+                      "\"rep\": %d, \"ok\": %s, \"gbps\": %.4f, \"latency_us\": %.4f}%s\n",
+                i, IMPLS[t->impl].name, t->threads, t->msg_size, t->rep, t->ok ? "true" : "false",
+                t->gbps, t->latency_us, i + 1 < n ? "," : "");
+    }
+    fprintf(json, "  ],\n  \"summary\": [\n");
+
+    // Server-side fan-out and scheduler reports, for the trials that produced one
+    fprintf(fan, "Order,Implementation,Threads,MsgSize,Rep,Subscribers,Published_per_s,"
+                 "Delivered_per_s,Fanout_Gbps,Dropped_per_s,Pool_KB,RSS_KB\n");
+    for (int i = 0; i < n; i++) {
+        const trial_t *t = &trials[i];
+        if (!t->has_fanout) continue;
+        const fanout_t *f = &t->fanout;
+        fprintf(fan, "%d,%s,%d,%d,%d,%d,%lld,%lld,%.3f,%lld,%ld,%ld\n", i, IMPLS[t->impl].name,
+                t->threads, t->msg_size, t->rep, f->subscribers, f->published, f->delivered,
+                f->gbps, f->dropped, f->pool_kb, f->rss_kb);
+    }
+    fprintf(sched, "Order,Implementation,Threads,MsgSize,Rep,Policy,Conns,Total_Gbps,Jain,"
+                   "Min_Mbps,Max_Mbps\n");
+    for (int i = 0; i < n; i++) {
+        const trial_t *t = &trials[i];
+        if (!t->has_sched) continue;
+        const sched_report_t *r = &t->sched;
+        fprintf(sched, "%d,%s,%d,%d,%d,%s,%d,%.3f,%.4f,%.2f,%.2f\n", i, IMPLS[t->impl].name,
+                t->threads, t->msg_size, t->rep, r->policy, r->conns, r->gbps, r->jain,
+                r->min_mbps, r->max_mbps);
+    }
+
+    // Per-cell statistics
+    fprintf(sum, "Implementation,Threads,MsgSize,N,Throughput_Mean_Gbps,Throughput_Std,"
+                 "Throughput_CI95,Latency_Mean_us,Latency_Std,Latency_CI95\n");
+    int first = 1;
+    for (int i = 0; i < NUM_IMPLS; i++) {
+        if (!use_impl[i]) continue;
+        for (int t = 0; t < num_threads; t++) {
+            for (int s = 0; s < num_sizes; s++) {
+                int k;
+                double gm, gsd, gci, lm, lsd, lci;
+                summarize(trials, n, i, threads[t], sizes[s], 0, &k, &gm, &gsd, &gci);
+                summarize(trials, n, i, threads[t], sizes[s], 1, &k, &lm, &lsd, &lci);
+
+                fprintf(sum, "%s,%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", IMPLS[i].name,
+                        threads[t], sizes[s], k, gm, gsd, gci, lm, lsd, lci);
+                fprintf(json, "%s    {\"impl\": \"%s\", \"threads\": %d, \"msg_size\": %d, \"n\": %d, "
+                              "\"gbps_mean\": %.4f, \"gbps_std\": %.4f, \"gbps_ci95\": %.4f, "
+                              "\"latency_mean_us\": %.4f, \"latency_std\": %.4f, \"latency_ci95\": %.4f}",
+                        first ? "" : ",\n", IMPLS[i].name, threads[t], sizes[s], k,
+                        gm, gsd, gci, lm, lsd, lci);
+                first = 0;
+            }
+        }
+    }
+    fprintf(json, "\n  ]\n}\n");
+
+    fclose(raw);
+    fclose(sum);
+    fclose(json);
+    fclose(fan);
+    fclose(sched);
+    free(trials);
+    printf("Wrote %s_trials.csv, %s_summary.csv, %s_fanout.csv, %s_sched.csv and %s.json\n",
+           prefix, prefix, prefix, prefix, prefix);
+    return 0;
+}
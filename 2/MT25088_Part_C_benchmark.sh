@@ -5,7 +5,24 @@
 declare -A SERVERS
 SERVERS=( ["Two-Copy"]="./server_a1"
           ["One-Copy"]="./server_a2"
-          ["Zero-Copy"]="./server_a3" )
+          ["Zero-Copy"]="./server_a3"
+          ["Sendfile"]="./server_a4 memfd sendfile"
+          ["Splice"]="./server_a4 memfd splice"
+          ["Sendfile-Cold"]="./server_a4 disk-cold sendfile"
+          ["Broadcast"]="./server_a5 iovec block"
+          ["Scheduled"]="./server_a6 drr" )
+
+# Socket profile strategy each server uses, passed to the client so both
+# ends apply the same profile entry (as the driver does)
+declare -A STRATEGIES
+STRATEGIES=( ["Two-Copy"]="two-copy"
+             ["One-Copy"]="one-copy"
+             ["Zero-Copy"]="zero-copy"
+             ["Sendfile"]="one-copy"
+             ["Splice"]="one-copy"
+             ["Sendfile-Cold"]="one-copy"
+             ["Broadcast"]="one-copy"
+             ["Scheduled"]="one-copy" )
 
 CLIENT="./client_b"
 SERVER_IP="127.0.0.1"
@@ -17,6 +34,35 @@ THREADS=(1 2 4 8)
 OUT_DIR="experiment_data_v4"
 CSV_FILE="final_results_v4.csv"
 
+# --- EMULATED NETWORK (optional) ---
+# --netns puts the server and client in separate network namespaces joined
+# by a veth pair, with netem shaping on both ends. DELAY is one-way (so the
+# RTT is 2x DELAY); RATE and LOSS apply to the data direction (server egress).
+NETNS=0
+DELAY="1ms"
+RATE=""
+LOSS=""
+NS_SRV="mt25088_srv"
+NS_CLI="mt25088_cli"
+SRV_ADDR="10.200.0.1"
+CLI_ADDR="10.200.0.2"
+
+usage() {
+    echo "Usage: $0 [--netns] [--delay 5ms] [--rate 1gbit] [--loss 0.1%]"
+    exit 1
+}
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --netns) NETNS=1 ;;
+        --delay) DELAY="$2"; shift ;;
+        --rate)  RATE="$2"; shift ;;
+        --loss)  LOSS="$2"; shift ;;
+        *) usage ;;
+    esac
+    shift
+done
+
 GREEN='\033[0;32m'
 YELLOW='\033[1;33m'
 RED='\033[0;31m'
@@ -28,15 +74,79 @@ err()  { echo -e "${RED}[ERR ]${NC} $1"; }
 
 command -v perf >/dev/null || { err "perf not installed"; exit 1; }
 
+# Command prefixes that run a program inside the server/client namespace
+SRV_EXEC=()
+CLI_EXEC=(sudo)
+
+teardown_netns() {
+    sudo ip netns del "$NS_SRV" 2>/dev/null
+    sudo ip netns del "$NS_CLI" 2>/dev/null
+    # A pair not yet moved into the namespaces (setup failed halfway, or a
+    # crashed run) would make the next "ip link add" fail
+    sudo ip link del veth_srv 2>/dev/null
+}
+
+setup_netns() {
+    command -v tc >/dev/null || { err "tc (iproute2) not installed"; exit 1; }
+    teardown_netns
+
+    sudo ip netns add "$NS_SRV" && sudo ip netns add "$NS_CLI" || { err "ip netns add failed"; exit 1; }
+    sudo ip link add veth_srv type veth peer name veth_cli || { err "veth creation failed"; exit 1; }
+    sudo ip link set veth_srv netns "$NS_SRV" || { err "moving veth_srv failed"; exit 1; }
+    sudo ip link set veth_cli netns "$NS_CLI" || { err "moving veth_cli failed"; exit 1; }
+
+    sudo ip -n "$NS_SRV" addr add "$SRV_ADDR/24" dev veth_srv || { err "server address failed"; exit 1; }
+    sudo ip -n "$NS_CLI" addr add "$CLI_ADDR/24" dev veth_cli || { err "client address failed"; exit 1; }
+    for ns in "$NS_SRV" "$NS_CLI"; do
+        sudo ip -n "$ns" link set lo up || { err "lo up failed in $ns"; exit 1; }
+    done
+    sudo ip -n "$NS_SRV" link set veth_srv up || { err "veth_srv up failed"; exit 1; }
+    sudo ip -n "$NS_CLI" link set veth_cli up || { err "veth_cli up failed"; exit 1; }
+
+    # Data direction carries the delay, rate cap and loss; ACK direction the delay only
+    local srv_netem="delay $DELAY"
+    [ -n "$RATE" ] && srv_netem="$srv_netem rate $RATE"
+    [ -n "$LOSS" ] && srv_netem="$srv_netem loss $LOSS"
+    sudo tc -n "$NS_SRV" qdisc add dev veth_srv root netem $srv_netem || { err "netem setup failed"; exit 1; }
+    sudo tc -n "$NS_CLI" qdisc add dev veth_cli root netem delay "$DELAY" || { err "netem setup failed"; exit 1; }
+
+    SRV_EXEC=(sudo ip netns exec "$NS_SRV")
+    CLI_EXEC=(sudo ip netns exec "$NS_CLI")
+    SERVER_IP="$SRV_ADDR"
+
+    info "netns mode: $SERVER_IP via veth, netem '$srv_netem' (ACK path: delay $DELAY)"
+}
+
+if [ "$NETNS" -eq 1 ]; then
+    # Installed first, so a failure inside setup_netns does not leak namespaces
+    trap teardown_netns EXIT
+    setup_netns
+
+    # Keep emulated-network results apart from the loopback ones
+    TAG="netns_d${DELAY}_r${RATE:-inf}_l${LOSS:-0}"
+    TAG=${TAG//%/pct}
+    OUT_DIR="${OUT_DIR}_${TAG}"
+    CSV_FILE="${CSV_FILE%.csv}_${TAG}.csv"
+fi
+
+# Server-side reports: the Broadcast server's FANOUT and the Scheduled
+# server's SCHED lines
+FANOUT_CSV="${CSV_FILE%.csv}_fanout.csv"
+SCHED_CSV="${CSV_FILE%.csv}_sched.csv"
+
 mkdir -p "$OUT_DIR"
-rm -f "$CSV_FILE"
+rm -f "$CSV_FILE" "$FANOUT_CSV" "$SCHED_CSV"
 
 echo "Implementation,Threads,MsgSize,Throughput_Gbps,Latency_us,Cycles,Instructions,L1_Misses,Cache_Misses,Context_Switches" \
     > "$CSV_FILE"
+echo "Implementation,Threads,MsgSize,Subscribers,Published_per_s,Delivered_per_s,Fanout_Gbps,Dropped_per_s,Pool_KB,RSS_KB" \
+    > "$FANOUT_CSV"
+echo "Implementation,Threads,MsgSize,Policy,Conns,Total_Gbps,Jain,Min_Mbps,Max_Mbps" \
+    > "$SCHED_CSV"
 
 wait_for_server() {
     for _ in {1..20}; do
-        ss -tuln | grep -q ":8080 " && return 0
+        "${SRV_EXEC[@]}" ss -tuln | grep -q ":8080 " && return 0
         sleep 0.25
     done
     return 1
@@ -45,13 +155,29 @@ wait_for_server() {
 cleanup_server() {
     local pid=$1
     kill -TERM "$pid" 2>/dev/null
+    # Under sudo/netns the PID is the wrapper, so also free the port directly
+    [ "$NETNS" -eq 1 ] && free_port
     wait "$pid" 2>/dev/null
 }
 
+free_port() {
+    if [ "$NETNS" -eq 1 ]; then
+        sudo ip netns exec "$NS_SRV" fuser -k 8080/tcp >/dev/null 2>&1
+    else
+        sudo fuser -k 8080/tcp >/dev/null 2>&1
+    fi
+}
+
 parse_perf() {
     grep "$1" "$2" | awk '{print $1}' | tr -d ',' | grep -E '^[0-9]+$'
 }
 
+# Last <tag> report whose count field is nonzero (a later one only covers
+# the client hanging up)
+last_report() {
+    awk -F',' -v tag="$1" -v f="$2" '$1 == tag && $f > 0 { last = $0 } END { print last }' "$3"
+}
+
 total=$(( ${#SERVERS[@]} * ${#THREADS[@]} * ${#SIZES[@]} ))
 count=0
 
@@ -63,14 +189,16 @@ for IMPL in "${!SERVERS[@]}"; do
             count=$((count + 1))
             info "[$count/$total] $IMPL | Threads=$T | MsgSize=$S"
 
-            sudo fuser -k 8080/tcp >/dev/null 2>&1
+            free_port
             sleep 0.3
 
             PERF_FILE="$OUT_DIR/perf_client_${IMPL}_t${T}_s${S}.txt"
             CLIENT_FILE="$OUT_DIR/client_${IMPL}_t${T}_s${S}.txt"
+            SERVER_FILE="$OUT_DIR/server_${IMPL}_t${T}_s${S}.txt"
 
             # Start server (NO perf here)
-            "$SERVER_BIN" &
+            # SERVER_BIN may carry arguments (A4 backing/method), so no quotes
+            "${SRV_EXEC[@]}" $SERVER_BIN > "$SERVER_FILE" 2>&1 &
             SERVER_PID=$!
 
             wait_for_server || {
@@ -83,10 +211,10 @@ for IMPL in "${!SERVERS[@]}"; do
             sleep 0.2
 
             # Run CLIENT under perf
-            sudo perf stat \
+            "${CLI_EXEC[@]}" perf stat \
                 -e cycles,instructions,L1-dcache-load-misses,cache-misses,context-switches \
                 -o "$PERF_FILE" \
-                "$CLIENT" "$SERVER_IP" "$T" "$S" "$DURATION" \
+                "$CLIENT" "$SERVER_IP" "$T" "$S" "$DURATION" "${STRATEGIES[$IMPL]}" \
                 > "$CLIENT_FILE" 2>&1
 
             cleanup_server "$SERVER_PID"
@@ -111,11 +239,25 @@ for IMPL in "${!SERVERS[@]}"; do
             echo "$IMPL,$T,$S,$Gbps,$LAT,${CYCLES},${INSTR},${L1MISS},${CMISS},${CSW}" \
                 >> "$CSV_FILE"
 
+            # FANOUT,<mode>,<policy>,<subscribers>,<msg_size>,<published/s>,<delivered/s>,
+            #        <fanout_gbps>,<dropped/s>,<pool_kb>,<rss_kb>
+            FANOUT=$(last_report FANOUT 4 "$SERVER_FILE")
+            [ -n "$FANOUT" ] && echo "$IMPL,$T,$S,$(echo "$FANOUT" | cut -d',' -f4,6-11)" >> "$FANOUT_CSV"
+
+            # SCHED,<policy>,<conns>,<total_gbps>,<jain>,<min_mbps>,<max_mbps>
+            SCHED=$(last_report SCHED 3 "$SERVER_FILE")
+            [ -n "$SCHED" ] && echo "$IMPL,$T,$S,$(echo "$SCHED" | cut -d',' -f2-7)" >> "$SCHED_CSV"
+
             info "  → $Gbps Gbps | $LAT µs"
         done
     done
 done
 
-sudo fuser -k 8080/tcp >/dev/null 2>&1
+free_port
 info "All experiments complete"
 info "CSV rows: $(($(wc -l < "$CSV_FILE") - 1))"
+info "Fan-out rows: $(($(wc -l < "$FANOUT_CSV") - 1)) in $FANOUT_CSV"
+info "Scheduler rows: $(($(wc -l < "$SCHED_CSV") - 1)) in $SCHED_CSV"
+
+# Append this run (with machine fingerprint) to the shared result store
+python3 ../result_store.py record --kind part2 --label "${TAG:-loopback}" "$CSV_FILE"
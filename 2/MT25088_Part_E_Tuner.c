@@ -0,0 +1,397 @@
+// MT25088_Part_E_Tuner.c
+// Socket buffer / send-watermark auto-tuner.
+//
+// For every (copy strategy, message size) pair this runs short loopback
+// transfers that reproduce the A1/A2/A3 send loops, and searches SO_SNDBUF,
+// SO_RCVBUF, TCP_NOTSENT_LOWAT and TCP_NODELAY one parameter at a time
+// (coordinate descent). The best setting per pair is written to the socket
+// profile that the servers and client load at startup.
+#include "MT25088_Part_A_common.h"
+#include <sys/uio.h>
+#include <linux/errqueue.h>
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#define NUM_STRATEGIES 3
+const char *STRATEGY_NAMES[NUM_STRATEGIES] = {"two-copy", "one-copy", "zero-copy"};
+
+// Candidate values (0 = leave the kernel default / autotuning in place)
+int SNDBUF_CANDIDATES[] = {0, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024};
+int RCVBUF_CANDIDATES[] = {0, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024};
+int LOWAT_CANDIDATES[] = {0, 16 * 1024, 128 * 1024, 1024 * 1024};
+int NODELAY_CANDIDATES[] = {1, 0};
+
+#define COUNT_OF(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// State shared by the sender, receiver and timing threads of one trial
+typedef struct {
+    int listen_fd;
+    int port;
+    int strategy;
+    size_t msg_size;
+    const SocketProfileEntry *profile;
+    atomic_llong bytes_received;
+    atomic_int stop;
+    int failed;
+} trial_t;
+
+double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Non-blocking drain of MSG_ZEROCOPY completions
+int drain_completions(int fd) {
+    char control[100];
+    int drained = 0;
+    while (1) {
+        struct msghdr msg = {0};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) break;
+        drained++;
+    }
+    return drained;
+}
+
+void *receiver_thread(void *arg) {
+    trial_t *t = (trial_t *)arg;
+    size_t buf_size = 256 * 1024;
+    char *buffer = malloc(buf_size);
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (!buffer || sock < 0) {
+        t->failed = 1;
+        shutdown(t->listen_fd, SHUT_RDWR); // Wake the sender out of accept()
+        free(buffer);
+        if (sock >= 0) close(sock);
+        return NULL;
+    }
+
+    // Receiver side of the profile must be applied before connect()
+    apply_socket_profile(sock, t->profile);
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(t->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Tuner connect failed");
+        t->failed = 1;
+        shutdown(t->listen_fd, SHUT_RDWR); // Wake the sender out of accept()
+        close(sock);
+        free(buffer);
+        return NULL;
+    }
+
+    while (1) {
+        ssize_t n = recv(sock, buffer, buf_size, 0);
+        if (n <= 0) break;
+        atomic_fetch_add(&t->bytes_received, n);
+    }
+
+    close(sock);
+    free(buffer);
+    return NULL;
+}
+
+void *sender_thread(void *arg) {
+    trial_t *t = (trial_t *)arg;
+    int fd = accept(t->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        t->failed = 1;
+        return NULL;
+    }
+
+    if (t->strategy == 2) {
+        int opt = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) < 0) {
+            t->failed = 1;
+            close(fd);
+            return NULL;
+        }
+    }
+    apply_socket_profile(fd, t->profile);
+
+    MessageStruct msg;
+    allocate_message(&msg, t->msg_size);
+
+    char *send_buffer = NULL;
+    if (t->strategy == 0) {
+        send_buffer = malloc(t->msg_size);
+        if (!send_buffer) {
+            perror("Buffer malloc failed");
+            t->failed = 1;
+            free_message(&msg);
+            close(fd);
+            return NULL;
+        }
+    }
+
+    struct msghdr msg_header = {0};
+    struct iovec iov[NUM_FIELDS];
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        iov[i].iov_base = msg.fields[i];
+        iov[i].iov_len = msg.field_sizes[i];
+    }
+    msg_header.msg_iov = iov;
+    msg_header.msg_iovlen = NUM_FIELDS;
+
+    int pending = 0;
+    while (!atomic_load(&t->stop)) {
+        ssize_t sent;
+        if (t->strategy == 0) {
+            // Same two copies as A1: serialize, then send()
+            size_t offset = 0;
+            for (int i = 0; i < NUM_FIELDS; i++) {
+                memcpy(send_buffer + offset, msg.fields[i], msg.field_sizes[i]);
+                offset += msg.field_sizes[i];
+            }
+            sent = send(fd, send_buffer, t->msg_size, 0);
+        } else if (t->strategy == 1) {
+            sent = sendmsg(fd, &msg_header, 0);
+        } else {
+            sent = sendmsg(fd, &msg_header, MSG_ZEROCOPY);
+            if (sent < 0 && errno == ENOBUFS) {
+                pending -= drain_completions(fd);
+                usleep(100);
+                continue;
+            }
+            if (sent > 0 && ++pending >= 16) pending -= drain_completions(fd);
+        }
+        if (sent <= 0) break;
+    }
+
+    if (t->strategy == 2) drain_completions(fd);
+    close(fd);
+    free(send_buffer);
+    free_message(&msg);
+    return NULL;
+}
+
+// Run one timed transfer and return its throughput in Gbps (-1 on failure)
+double run_trial(int strategy, size_t msg_size, const SocketProfileEntry *profile, double duration) {
+    trial_t t = {0};
+    t.strategy = strategy;
+    t.msg_size = msg_size;
+    t.profile = profile;
+    atomic_init(&t.bytes_received, 0);
+    atomic_init(&t.stop, 0);
+
+    t.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (t.listen_fd < 0) {
+        perror("Socket failed");
+        return -1.0;
+    }
+
+    struct sockaddr_in addr = {0};
+    socklen_t addrlen = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0; // Ephemeral port, so tuning never collides with a running server
+    if (bind(t.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(t.listen_fd, 1) < 0 ||
+        getsockname(t.listen_fd, (struct sockaddr *)&addr, &addrlen) < 0) {
+        perror("Tuner listen failed");
+        close(t.listen_fd);
+        return -1.0;
+    }
+    t.port = ntohs(addr.sin_port);
+
+    pthread_t sender, receiver;
+    if (pthread_create(&sender, NULL, sender_thread, &t) != 0) {
+        perror("Thread creation failed");
+        close(t.listen_fd);
+        return -1.0;
+    }
+    if (pthread_create(&receiver, NULL, receiver_thread, &t) != 0) {
+        perror("Thread creation failed");
+        shutdown(t.listen_fd, SHUT_RDWR);
+        pthread_join(sender, NULL);
+        close(t.listen_fd);
+        return -1.0;
+    }
+
+    // Short warmup so slow start and buffer growth are not measured
+    usleep(100000);
+    long long start_bytes = atomic_load(&t.bytes_received);
+    double start = now_sec();
+    usleep((useconds_t)(duration * 1000000.0));
+    long long end_bytes = atomic_load(&t.bytes_received);
+    double elapsed = now_sec() - start;
+
+    atomic_store(&t.stop, 1);
+    pthread_join(sender, NULL);
+    pthread_join(receiver, NULL);
+    close(t.listen_fd);
+
+    if (t.failed) return -1.0;
+    return (end_bytes - start_bytes) * 8.0 / (elapsed * 1e9);
+}
+
+// Median of n values (sorts them in place); the mean of the middle two for even n
+double median(double *v, int n) {
+    for (int i = 1; i < n; i++) {
+        double x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+// Median of `reps` trials, to keep one noisy run from picking the setting
+double measure(int strategy, size_t msg_size, const SocketProfileEntry *profile,
+               double duration, int reps) {
+    double results[16];
+    if (reps > 16) reps = 16;
+    for (int i = 0; i < reps; i++) {
+        results[i] = run_trial(strategy, msg_size, profile, duration);
+        if (results[i] < 0) return -1.0;
+    }
+    return median(results, reps);
+}
+
+// A candidate replaces the incumbent only if it is faster by more than this
+// fraction in the median of the paired trials and faster in every pair;
+// otherwise noise decides the profile
+#define NOISE_MARGIN 0.03
+
+// Run the incumbent and a candidate in alternating pairs, so slow drift of
+// the host (frequency, other load) hits both alike. Returns 1 if the
+// candidate wins, with its median throughput in *gbps; -1 on failure.
+int candidate_wins(int strategy, size_t msg_size, const SocketProfileEntry *incumbent,
+                   const SocketProfileEntry *candidate, double duration, int reps, double *gbps) {
+    double ratios[16], results[16];
+    int all_faster = 1;
+    if (reps > 16) reps = 16;
+    for (int i = 0; i < reps; i++) {
+        double inc = run_trial(strategy, msg_size, incumbent, duration);
+        results[i] = run_trial(strategy, msg_size, candidate, duration);
+        if (inc <= 0 || results[i] < 0) return -1;
+        ratios[i] = results[i] / inc;
+        if (ratios[i] <= 1.0) all_faster = 0;
+    }
+    *gbps = median(results, reps);
+    return all_faster && median(ratios, reps) > 1.0 + NOISE_MARGIN;
+}
+
+// The four tunable fields of a profile entry, in search order
+int *profile_param(SocketProfileEntry *e, int p) {
+    switch (p) {
+    case 0: return &e->sndbuf;
+    case 1: return &e->rcvbuf;
+    case 2: return &e->notsent_lowat;
+    default: return &e->nodelay;
+    }
+}
+
+// Coordinate descent over the four parameters for one (strategy, size) pair
+double tune(int strategy, size_t msg_size, double duration, int reps, SocketProfileEntry *best) {
+    memset(best, 0, sizeof(*best));
+    snprintf(best->strategy, sizeof(best->strategy), "%s", STRATEGY_NAMES[strategy]);
+    best->msg_size = msg_size;
+    best->nodelay = 1;
+
+    double best_gbps = measure(strategy, msg_size, best, duration, reps);
+    if (best_gbps < 0) return -1.0;
+
+    int *candidates[4] = {SNDBUF_CANDIDATES, RCVBUF_CANDIDATES, LOWAT_CANDIDATES, NODELAY_CANDIDATES};
+    int counts[4] = {COUNT_OF(SNDBUF_CANDIDATES), COUNT_OF(RCVBUF_CANDIDATES),
+                     COUNT_OF(LOWAT_CANDIDATES), COUNT_OF(NODELAY_CANDIDATES)};
+
+    for (int p = 0; p < 4; p++) {
+        int kept = *profile_param(best, p);
+        for (int c = 0; c < counts[p]; c++) {
+            if (candidates[p][c] == kept) continue;
+
+            SocketProfileEntry trial = *best;
+            *profile_param(&trial, p) = candidates[p][c];
+
+            double gbps;
+            if (candidate_wins(strategy, msg_size, best, &trial, duration, reps, &gbps) == 1) {
+                best_gbps = gbps;
+                *best = trial;
+            }
+        }
+    }
+    return best_gbps;
+}
+
+int main(int argc, char *argv[]) {
+    const char *out_path = getenv(SOCK_PROFILE_ENV);
+    if (!out_path) out_path = SOCK_PROFILE_DEFAULT;
+    char sizes_arg[256] = "1024,4096,16384,65536,524288,2097152,10485760";
+    char strategies_arg[64] = "two-copy,one-copy,zero-copy";
+    double duration = 0.5;
+    int reps = 5;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:s:S:d:r:h")) != -1) {
+        switch (opt) {
+        case 'o': out_path = optarg; break;
+        case 's': snprintf(sizes_arg, sizeof(sizes_arg), "%s", optarg); break;
+        case 'S': snprintf(strategies_arg, sizeof(strategies_arg), "%s", optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'r': reps = atoi(optarg); break;
+        default:
+            fprintf(stderr, "Usage: %s [-o profile] [-s size,size,...] [-S strategy,...] "
+                            "[-d trial_seconds] [-r repetitions]\n", argv[0]);
+            return opt == 'h' ? 0 : -1;
+        }
+    }
+    if (duration <= 0 || reps < 1) {
+        fprintf(stderr, "Invalid duration or repetition count\n");
+        return -1;
+    }
+
+    FILE *out = fopen(out_path, "w");
+    if (!out) {
+        perror("Cannot open profile for writing");
+        return -1;
+    }
+    time_t now = time(NULL);
+    fprintf(out, "# MT25088 socket profile, generated %s", ctime(&now));
+    fprintf(out, "# strategy msg_size sndbuf rcvbuf notsent_lowat nodelay gbps\n");
+
+    for (int s = 0; s < NUM_STRATEGIES; s++) {
+        if (!strstr(strategies_arg, STRATEGY_NAMES[s])) continue;
+
+        char sizes[256];
+        snprintf(sizes, sizeof(sizes), "%s", sizes_arg);
+        for (char *tok = strtok(sizes, ","); tok; tok = strtok(NULL, ",")) {
+            size_t msg_size = strtoul(tok, NULL, 10);
+            if (msg_size < MIN_MSG_SIZE || msg_size > MAX_MSG_SIZE) {
+                fprintf(stderr, "Skipping invalid message size: %s\n", tok);
+                continue;
+            }
+
+            SocketProfileEntry best;
+            double gbps = tune(s, msg_size, duration, reps, &best);
+            if (gbps < 0) {
+                fprintf(stderr, "%s unsupported here, skipping\n", STRATEGY_NAMES[s]);
+                break;
+            }
+
+            printf("%-9s %8zu -> sndbuf=%d rcvbuf=%d lowat=%d nodelay=%d (%.2f Gbps)\n",
+                   best.strategy, best.msg_size, best.sndbuf, best.rcvbuf,
+                   best.notsent_lowat, best.nodelay, gbps);
+            fprintf(out, "%s %zu %d %d %d %d %.2f\n", best.strategy, best.msg_size,
+                    best.sndbuf, best.rcvbuf, best.notsent_lowat, best.nodelay, gbps);
+            fflush(out);
+        }
+    }
+
+    fclose(out);
+    printf("Profile written to %s\n", out_path);
+    return 0;
+}
@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+# Versioned benchmark result store with machine fingerprint and regression check.
+#
+#   python3 result_store.py record --kind part1 1/results.csv
+#   python3 result_store.py list
+#   python3 result_store.py compare previous latest
+#   python3 result_store.py compare commit:abc1234 commit:def5678
+#
+# Every recorded run is stored as one JSON file under results_store/runs/
+# (override with $MT25088_RESULT_STORE) together with the machine fingerprint
+# (CPU model, kernel, governor, SMT, THP, ...) and the git commit it came from.
+# `compare` groups rows by the kind's key columns and flags metrics that moved
+# by more than the threshold: with repeated samples per cell a Welch t-test
+# must also be significant, single-sample cells are flagged on threshold only.
+# Only the Python standard library is used.
+import argparse
+import csv
+import json
+import math
+import os
+import platform
+import socket
+import subprocess
+import sys
+from datetime import datetime
+
+SCHEMA_VERSION = 1
+ROOT = os.path.dirname(os.path.abspath(__file__))
+STORE = os.environ.get("MT25088_RESULT_STORE", os.path.join(ROOT, "results_store"))
+
+# Per-CSV layout: which columns identify a cell, which are metrics, and
+# whether a metric is better when higher (+1) or lower (-1).
+KINDS = {
+    # 1/results.csv from bench.sh
+    "part1": {
+        "keys": ["Program", "Function", "Count"],
+        "metrics": {"Time(s)": -1},
+    },
+    # 1/worker_stats.csv written by progA/progB themselves (run rows only)
+    "part1-stats": {
+        "keys": ["program", "worker", "count"],
+        "metrics": {"wall_s": -1, "user_s": -1, "sys_s": -1, "minflt": -1,
+                    "nvcsw": -1, "nivcsw": -1},
+        "filter": ("scope", "run"),
+    },
+    # 2/final_results_v4*.csv from MT25088_Part_C_benchmark.sh
+    "part2": {
+        "keys": ["Implementation", "Threads", "MsgSize"],
+        "metrics": {"Throughput_Gbps": +1, "Latency_us": -1, "Cycles": -1,
+                    "Cache_Misses": -1, "Context_Switches": -1},
+    },
+    # 2/driver_results_trials.csv from the native driver (one row per trial)
+    "part2-trials": {
+        "keys": ["Implementation", "Threads", "MsgSize"],
+        "metrics": {"Throughput_Gbps": +1, "Latency_us": -1},
+        "filter": ("Ok", "1"),
+    },
+}
+
+
+# --- Fingerprint ---
+
+def read_first(path, default="unknown"):
+    try:
+        with open(path) as f:
+            return f.read().strip()
+    except OSError:
+        return default
+
+
+def cpu_model():
+    for line in read_first("/proc/cpuinfo", "").splitlines():
+        if line.startswith("model name"):
+            return line.split(":", 1)[1].strip()
+    return platform.processor() or "unknown"
+
+
+def thp_setting():
+    # "always [madvise] never" -> "madvise"
+    raw = read_first("/sys/kernel/mm/transparent_hugepage/enabled")
+    if "[" in raw:
+        return raw[raw.index("[") + 1:raw.index("]")]
+    return raw
+
+
+def git(*args):
+    try:
+        return subprocess.check_output(["git", "-C", ROOT] + list(args),
+                                       stderr=subprocess.DEVNULL, text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+
+def fingerprint():
+    return {
+        "hostname": socket.gethostname(),
+        "cpu_model": cpu_model(),
+        "cpus": os.cpu_count(),
+        "kernel": platform.release(),
+        "governor": read_first("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor"),
+        "smt": read_first("/sys/devices/system/cpu/smt/control"),
+        "thp": thp_setting(),
+        "commit": git("rev-parse", "HEAD") or "unknown",
+        "dirty": bool(git("status", "--porcelain", "--untracked-files=no")),
+    }
+
+
+# --- Store ---
+
+def runs_dir():
+    path = os.path.join(STORE, "runs")
+    os.makedirs(path, exist_ok=True)
+    return path
+
+
+def load_runs():
+    runs = []
+    for name in sorted(os.listdir(runs_dir())):
+        if name.endswith(".json"):
+            with open(os.path.join(runs_dir(), name)) as f:
+                runs.append(json.load(f))
+    runs.sort(key=lambda r: (r["timestamp"], r["run_id"]))
+    return runs
+
+
+def record(args):
+    if args.kind not in KINDS:
+        sys.exit(f"Unknown kind '{args.kind}' (known: {', '.join(KINDS)})")
+    with open(args.csv) as f:
+        rows = list(csv.DictReader(f))
+    if not rows:
+        sys.exit(f"No rows in {args.csv}")
+
+    fp = fingerprint()
+    now = datetime.now()
+    run_id = f"{now.strftime('%Y%m%dT%H%M%S')}-{args.kind}-{fp['commit'][:7]}"
+    suffix = 1
+    while os.path.exists(os.path.join(runs_dir(), run_id + ".json")):
+        suffix += 1
+        run_id = f"{now.strftime('%Y%m%dT%H%M%S')}-{args.kind}-{fp['commit'][:7]}-{suffix}"
+    run = {
+        "schema_version": SCHEMA_VERSION,
+        "run_id": run_id,
+        "timestamp": now.isoformat(timespec="seconds"),
+        "kind": args.kind,
+        "label": args.label,
+        "source": os.path.abspath(args.csv),
+        "fingerprint": fp,
+        "rows": rows,
+    }
+    with open(os.path.join(runs_dir(), run_id + ".json"), "w") as f:
+        json.dump(run, f, indent=1)
+
+    index = os.path.join(STORE, "index.csv")
+    new_index = not os.path.exists(index)
+    with open(index, "a", newline="") as f:
+        w = csv.writer(f)
+        if new_index:
+            w.writerow(["run_id", "timestamp", "kind", "label", "commit", "dirty",
+                        "cpu_model", "kernel", "governor", "smt", "thp", "rows"])
+        w.writerow([run_id, run["timestamp"], args.kind, args.label, fp["commit"][:12],
+                    fp["dirty"], fp["cpu_model"], fp["kernel"], fp["governor"],
+                    fp["smt"], fp["thp"], len(rows)])
+    print(f"Recorded {len(rows)} rows as {run_id}")
+
+
+def list_runs(args):
+    for run in load_runs():
+        fp = run["fingerprint"]
+        print(f"{run['run_id']:40s} {run['kind']:13s} {len(run['rows']):5d} rows  "
+              f"{fp['commit'][:7]}{'+' if fp['dirty'] else ''}  {fp['kernel']}  {run['label']}")
+
+
+def resolve(spec, runs, kind=None, before=None):
+    """Run id, 'latest', 'previous', or 'commit:<sha>' (latest run at that commit).
+
+    'previous' is the last run before `before` (a resolved run), or the one
+    before the latest when no run is given."""
+    candidates = [r for r in runs if kind is None or r["kind"] == kind]
+    if spec == "latest" and candidates:
+        return candidates[-1]
+    if spec == "previous":
+        ids = [r["run_id"] for r in candidates]
+        end = ids.index(before["run_id"]) if before and before["run_id"] in ids else len(ids) - 1
+        if end > 0:
+            return candidates[end - 1]
+        if before:
+            sys.exit(f"No {before['kind']} run before {before['run_id']}")
+    if spec.startswith("commit:"):
+        sha = spec.split(":", 1)[1]
+        matches = [r for r in candidates if r["fingerprint"]["commit"].startswith(sha)]
+        if matches:
+            return matches[-1]
+    for r in candidates:
+        if r["run_id"] == spec or r["run_id"].startswith(spec):
+            return r
+    sys.exit(f"No run matches '{spec}'")
+
+
+# --- Statistics ---
+
+def betacf(a, b, x):
+    # Continued fraction for the incomplete beta function (modified Lentz)
+    tiny = 1e-300
+
+    def clamp(v):
+        return v if abs(v) > tiny else tiny
+
+    qab, qap, qam = a + b, a + 1.0, a - 1.0
+    c, d = 1.0, 1.0 / clamp(1.0 - qab * x / qap)
+    h = d
+    for m in range(1, 200):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 / clamp(1.0 + aa * d)
+        c = clamp(1.0 + aa / c)
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 / clamp(1.0 + aa * d)
+        c = clamp(1.0 + aa / c)
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betainc(a, b, x):
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    lbeta = math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+    front = math.exp(lbeta + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def welch_p(xs, ys):
+    """Two-sided p-value of Welch's t-test (None if it cannot be computed)."""
+    n1, n2 = len(xs), len(ys)
+    if n1 < 2 or n2 < 2:
+        return None
+    m1, m2 = sum(xs) / n1, sum(ys) / n2
+    v1 = sum((x - m1) ** 2 for x in xs) / (n1 - 1)
+    v2 = sum((y - m2) ** 2 for y in ys) / (n2 - 1)
+    se2 = v1 / n1 + v2 / n2
+    if se2 == 0.0:
+        return 0.0 if m1 != m2 else 1.0
+    t = (m2 - m1) / math.sqrt(se2)
+    df = se2 ** 2 / ((v1 / n1) ** 2 / (n1 - 1) + (v2 / n2) ** 2 / (n2 - 1))
+    return betainc(df / 2.0, 0.5, df / (df + t * t))
+
+
+def cells(run):
+    """{key tuple: {metric: [samples]}} for one run."""
+    spec = KINDS[run["kind"]]
+    out = {}
+    for row in run["rows"]:
+        flt = spec.get("filter")
+        if flt and row.get(flt[0]) != flt[1]:
+            continue
+        key = tuple(row.get(k, "") for k in spec["keys"])
+        for metric in spec["metrics"]:
+            try:
+                value = float(row[metric])
+            except (KeyError, TypeError, ValueError):
+                continue
+            out.setdefault(key, {}).setdefault(metric, []).append(value)
+    return out
+
+
+def compare(args):
+    runs = load_runs()
+    # new first: 'previous' then means the run of new's kind before it
+    new = resolve(args.new, runs, args.kind)
+    base = resolve(args.base, runs, args.kind or new["kind"], before=new)
+    if base["kind"] != new["kind"]:
+        sys.exit(f"Cannot compare kind '{base['kind']}' with '{new['kind']}'")
+    if base["run_id"] == new["run_id"]:
+        sys.exit(f"Base and new are the same run ({new['run_id']})")
+    spec = KINDS[base["kind"]]
+
+    print(f"Base: {base['run_id']}  ({base['fingerprint']['commit'][:7]})")
+    print(f"New:  {new['run_id']}  ({new['fingerprint']['commit'][:7]})")
+    fb, fn = base["fingerprint"], new["fingerprint"]
+    for field in ("cpu_model", "cpus", "kernel", "governor", "smt", "thp"):
+        if fb.get(field) != fn.get(field):
+            print(f"  WARNING: machine differs in {field}: {fb.get(field)} -> {fn.get(field)}")
+    print()
+
+    base_cells, new_cells = cells(base), cells(new)
+    regressions = improvements = 0
+    for key in sorted(set(base_cells) & set(new_cells)):
+        for metric, direction in spec["metrics"].items():
+            xs = base_cells[key].get(metric)
+            ys = new_cells[key].get(metric)
+            if not xs or not ys:
+                continue
+            m1, m2 = sum(xs) / len(xs), sum(ys) / len(ys)
+            if m1 == 0.0:
+                continue
+            change = (m2 - m1) / abs(m1)
+            p = welch_p(xs, ys)
+            if abs(change) < args.threshold:
+                continue
+            if p is not None and p >= args.alpha:
+                continue
+
+            better = change * direction > 0
+            verdict = "IMPROVED " if better else "REGRESSED"
+            if better:
+                improvements += 1
+            else:
+                regressions += 1
+            evidence = f"p={p:.4f}" if p is not None else "n=1, threshold only"
+            print(f"{verdict} {'/'.join(key):28s} {metric:18s} "
+                  f"{m1:12.4g} -> {m2:12.4g} ({change * 100:+6.1f}%, {evidence})")
+
+    print(f"\n{regressions} regression(s), {improvements} improvement(s) "
+          f"(threshold {args.threshold * 100:.0f}%, alpha {args.alpha})")
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark result store")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("record", help="append a CSV run to the store")
+    p.add_argument("--kind", required=True, choices=sorted(KINDS))
+    p.add_argument("--label", default="")
+    p.add_argument("csv")
+
+    sub.add_parser("list", help="list recorded runs")
+
+    p = sub.add_parser("compare", help="flag significant changes between two runs")
+    p.add_argument("base", help="run id, 'previous', 'latest' or commit:<sha>")
+    p.add_argument("new", help="run id, 'previous', 'latest' or commit:<sha>")
+    p.add_argument("--kind", choices=sorted(KINDS), help="restrict run lookup to one kind")
+    p.add_argument("--threshold", type=float, default=0.05,
+                   help="minimum relative change to report (default 0.05)")
+    p.add_argument("--alpha", type=float, default=0.05,
+                   help="significance level for replicated cells (default 0.05)")
+
+    args = parser.parse_args()
+    if args.cmd == "record":
+        record(args)
+    elif args.cmd == "list":
+        list_runs(args)
+    else:
+        sys.exit(compare(args))
+
+
+if __name__ == "__main__":
+    main()